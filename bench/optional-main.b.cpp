@@ -0,0 +1,115 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.b.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+
+#if optional_CPP11_OR_GREATER
+# include <chrono>
+#endif
+
+namespace bench {
+
+benchmarks & registry()
+{
+    static benchmarks list;
+    return list;
+}
+
+// elapsed time in seconds:
+
+class timer
+{
+public:
+#if optional_CPP11_OR_GREATER
+    timer() : start_( std::chrono::steady_clock::now() ) {}
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now() - start_ ).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+#else
+    timer() : start_( std::clock() ) {}
+
+    double elapsed() const
+    {
+        return static_cast<double>( std::clock() - start_ ) / CLOCKS_PER_SEC;
+    }
+
+private:
+    std::clock_t start_;
+#endif
+};
+
+// run benchmark for at least min_time seconds, return nanoseconds per operation:
+
+double measure( function fn, double min_time )
+{
+    fn( 1 );    // warm up
+
+    for ( std::size_t rounds = 1; ; rounds *= 2 )
+    {
+        timer t;
+        const std::size_t ops = fn( rounds );
+        const double elapsed  = t.elapsed();
+
+        if ( elapsed >= min_time || rounds >= ( std::size_t(1) << 30 ) )
+            return 1e9 * elapsed / static_cast<double>( ops );
+    }
+}
+
+} // namespace bench
+
+int main( int argc, char * argv[] )
+{
+    using namespace bench;
+
+    // usage: optional-bare-cppNN.b [--quick] [filter]
+
+    double min_time = 0.2;
+    char const * filter = "";
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( 0 == std::strcmp( argv[i], "--quick" ) ) min_time = 0.01;
+        else                                          filter   = argv[i];
+    }
+
+    std::cout <<
+        "optional bare " << optional_bare_VERSION << ", __cplusplus: " << optional_CPLUSPLUS <<
+        ", std::optional: " << ( optional_HAVE_STD_OPTIONAL ? "yes" : "no" ) << "\n\n" <<
+        std::left << std::setw(24) << "benchmark" << std::setw(12) << "type" << std::setw(16) << "impl" << std::right << std::setw(12) << "ns/op" << "\n";
+
+    for ( benchmarks::const_iterator pos = registry().begin(); pos != registry().end(); ++pos )
+    {
+        if ( std::string::npos == ( pos->name + " " + pos->type + " " + pos->impl ).find( filter ) )
+            continue;
+
+        std::cout <<
+            std::left  << std::setw(24) << pos->name << std::setw(12) << pos->type << std::setw(16) << pos->impl <<
+            std::right << std::setw(12) << std::fixed << std::setprecision(3) << measure( pos->fn, min_time ) << "\n" << std::flush;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#if 0
+g++ -O2 -std=c++98 -I../include -o optional-main.b.exe optional-main.b.cpp optional.b.cpp && optional-main.b.exe
+g++ -O2 -std=c++17 -I../include -o optional-main.b.exe optional-main.b.cpp optional.b.cpp && optional-main.b.exe
+
+cl -O2 -EHsc -std:c++17 -I../include optional-main.b.cpp optional.b.cpp && optional-main.b.exe
+#endif
+
+// end of file
@@ -0,0 +1,99 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#pragma once
+
+#ifndef BENCH_OPTIONAL_BARE_H_INCLUDED
+#define BENCH_OPTIONAL_BARE_H_INCLUDED
+
+// Benchmarks compare nonstd::optional_bare::optional with std::optional (C++17),
+// hence always select optional bare's own optional:
+
+#ifndef  optional_CONFIG_SELECT_OPTIONAL
+# define optional_CONFIG_SELECT_OPTIONAL  optional_OPTIONAL_NONSTD
+#endif
+
+#include "nonstd/optional.hpp"
+
+#if optional_USES_STD_OPTIONAL
+# error "Benchmarks require optional_CONFIG_SELECT_OPTIONAL=optional_OPTIONAL_NONSTD"
+#endif
+
+#if optional_HAVE_STD_OPTIONAL
+# include <optional>
+#endif
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// benchmark function: perform the given number of rounds, return number of operations:
+
+typedef std::size_t (*function)( std::size_t rounds );
+
+struct benchmark
+{
+    std::string name;
+    std::string type;
+    std::string impl;
+    function    fn;
+};
+
+typedef std::vector<benchmark> benchmarks;
+
+benchmarks & registry();
+
+inline void add( char const * name, char const * type, char const * impl, function fn )
+{
+    benchmark b;
+    b.name = name;
+    b.type = type;
+    b.impl = impl;
+    b.fn   = fn;
+    registry().push_back( b );
+}
+
+// prevent the compiler from optimizing away a computed value:
+
+template< typename T >
+inline void do_not_optimize( T const & value )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    __asm__ __volatile__( "" : : "g"( &value ) : "memory" );
+#else
+    static void const * volatile sink;
+    sink = &value;
+#endif
+}
+
+// deterministic pseudo-random numbers (linear congruential generator):
+
+class lcg
+{
+public:
+    explicit lcg( unsigned long seed = 42 )
+    : state_( seed ) {}
+
+    // the high bits, as the low bits of the state have short periods:
+
+    unsigned long operator()()
+    {
+        state_ = ( state_ * 1103515245UL + 12345UL ) & 0x7fffffffUL;
+        return state_ >> 16;
+    }
+
+private:
+    unsigned long state_;
+};
+
+} // namespace bench
+
+#endif // BENCH_OPTIONAL_BARE_H_INCLUDED
+
+// end of file
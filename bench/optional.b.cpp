@@ -0,0 +1,1063 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.b.hpp"
+#include "nonstd/optional_algorithm.hpp"
+#include "nonstd/flat_optional_map.hpp"
+#include "nonstd/slot_map.hpp"
+#include "nonstd/atomic_optional.hpp"
+#include "nonstd/lazy_optional.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <cstring>
+#include <map>
+
+#if optional_CPP11_OR_GREATER
+# include <mutex>
+# include <thread>
+# include <unordered_map>
+#endif
+
+using namespace bench;
+
+namespace {
+
+// number of operations per round:
+
+const std::size_t batch = 1024;
+
+// value types of various sizes:
+
+struct blob32
+{
+    unsigned long data[ 32 / sizeof( unsigned long ) ];
+};
+
+inline bool operator==( blob32 const & a, blob32 const & b ) { return 0 == std::memcmp( a.data, b.data, sizeof a.data ); }
+inline bool operator< ( blob32 const & a, blob32 const & b ) { return a.data[0] < b.data[0]; }
+
+template< typename T > T make_value( unsigned long i );
+
+template<> int make_value<int>( unsigned long i )
+{
+    return static_cast<int>( i );
+}
+
+template<> double make_value<double>( unsigned long i )
+{
+    return static_cast<double>( i ) / 7.0;
+}
+
+template<> blob32 make_value<blob32>( unsigned long i )
+{
+    blob32 b;
+    std::fill( b.data, b.data + sizeof b.data / sizeof b.data[0], i );
+    return b;
+}
+
+template<> std::string make_value<std::string>( unsigned long i )
+{
+    // longer than the small-string buffer, so that copies allocate:
+    return std::string( 40, static_cast<char>( 'a' + i % 26 ) );
+}
+
+// values and optionals, half of them empty:
+
+template< typename T >
+std::vector<T> const & values()
+{
+    static std::vector<T> data;
+
+    if ( data.empty() )
+    {
+        lcg rnd;
+        for ( std::size_t i = 0; i < batch; ++i )
+            data.push_back( make_value<T>( rnd() ) );
+    }
+    return data;
+}
+
+template< template<typename> class Opt, typename T >
+std::vector< Opt<T> > const & inputs()
+{
+    static std::vector< Opt<T> > data;
+
+    if ( data.empty() )
+    {
+        lcg rnd( 7 );
+        for ( std::size_t i = 0; i < batch; ++i )
+            data.push_back( rnd() % 2 ? Opt<T>( values<T>()[i] ) : Opt<T>() );
+    }
+    return data;
+}
+
+// benchmarks:
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_construct_empty( std::size_t rounds )
+{
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            Opt<T> o;
+            do_not_optimize( o );
+        }
+    }
+    return rounds * batch;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_construct_value( std::size_t rounds )
+{
+    std::vector<T> const & in = values<T>();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            Opt<T> o( in[i] );
+            do_not_optimize( o );
+        }
+    }
+    return rounds * batch;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_copy( std::size_t rounds )
+{
+    std::vector< Opt<T> > const & in = inputs<Opt, T>();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            Opt<T> o( in[i] );
+            do_not_optimize( o );
+        }
+    }
+    return rounds * batch;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_assign( std::size_t rounds )
+{
+    std::vector< Opt<T> > const & in = inputs<Opt, T>();
+    std::vector< Opt<T> > out( in );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            out[i] = in[ ( i + r + 1 ) % batch ];
+        }
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_swap( std::size_t rounds )
+{
+    std::vector< Opt<T> > v( inputs<Opt, T>() );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            using std::swap;
+            swap( v[i], v[ batch - 1 - i ] );
+        }
+        do_not_optimize( v );
+    }
+    return rounds * batch;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_value_or( std::size_t rounds )
+{
+    std::vector< Opt<T> > const & in = inputs<Opt, T>();
+    T const dflt = make_value<T>( 0 );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            T v = in[i].value_or( dflt );
+            do_not_optimize( v );
+        }
+    }
+    return rounds * batch;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_compare( std::size_t rounds )
+{
+    std::vector< Opt<T> > const & in = inputs<Opt, T>();
+    std::size_t count = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            count += in[i] < in[ ( i + r + 1 ) % batch ];
+            count += in[i] == in[ ( i + r + 1 ) % batch ];
+        }
+        do_not_optimize( count );
+    }
+    return rounds * batch * 2;
+}
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_sort( std::size_t rounds )
+{
+    std::vector< Opt<T> > const & in = inputs<Opt, T>();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        std::vector< Opt<T> > v( in );
+        std::sort( v.begin(), v.end() );
+        do_not_optimize( v );
+    }
+    return rounds * batch;
+}
+
+#if optional_CPP11_OR_GREATER
+
+template< template<typename> class Opt, typename T >
+std::size_t bm_hash( std::size_t rounds )
+{
+    std::vector< Opt<T> > const & in = inputs<Opt, T>();
+    std::hash< Opt<T> > hasher;
+    std::size_t h = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            h += hasher( in[i] );
+        }
+        do_not_optimize( h );
+    }
+    return rounds * batch;
+}
+
+// monadic operations versus hand-written branches, nonstd::optional only:
+
+typedef nonstd::optional_bare::optional<int> optional_int;
+
+inline optional_int half( int x )
+{
+    return x % 2 ? optional_int() : optional_int( x / 2 );
+}
+
+std::size_t bm_chain_branches( std::size_t rounds )
+{
+    std::vector< optional_int > const & in = inputs< nonstd::optional_bare::optional, int >();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            int v = -1;
+            if ( in[i] )
+            {
+                optional_int h = half( *in[i] );
+                if ( h )
+                    v = *h + 1;
+            }
+            do_not_optimize( v );
+        }
+    }
+    return rounds * batch;
+}
+
+std::size_t bm_chain_monadic( std::size_t rounds )
+{
+    std::vector< optional_int > const & in = inputs< nonstd::optional_bare::optional, int >();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            int v = in[i].and_then( half ).transform( []( int x ) { return x + 1; } ).value_or( -1 );
+            do_not_optimize( v );
+        }
+    }
+    return rounds * batch;
+}
+
+// fallback std::string that is expensive to create:
+
+std::string make_fallback()
+{
+    return make_value<std::string>( 0 );
+}
+
+std::size_t bm_fallback_value_or( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<std::string> > const & in = inputs< nonstd::optional_bare::optional, std::string >();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            std::string v = in[i].value_or( make_fallback() );
+            do_not_optimize( v );
+        }
+    }
+    return rounds * batch;
+}
+
+std::size_t bm_fallback_value_or_else( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<std::string> > const & in = inputs< nonstd::optional_bare::optional, std::string >();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            std::string v = in[i].value_or_else( make_fallback );
+            do_not_optimize( v );
+        }
+    }
+    return rounds * batch;
+}
+
+// latest value or nothing, shared between threads: an optional behind a mutex:
+
+template< typename T >
+class locked_optional
+{
+public:
+    nonstd::optional_bare::optional<T> load()
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        return value_;
+    }
+
+    void store( nonstd::optional_bare::optional<T> const & v )
+    {
+        std::lock_guard<std::mutex> lock( mutex_ );
+        value_ = v;
+    }
+
+private:
+    std::mutex mutex_;
+    nonstd::optional_bare::optional<T> value_;
+};
+
+// one thread publishes values, three threads read the latest one, per operation:
+
+std::size_t const contention_threads = 4;
+
+template< typename Shared, typename T >
+std::size_t bm_contention( std::size_t rounds )
+{
+    Shared shared;
+    std::vector< std::thread > threads;
+
+    for ( std::size_t t = 0; t < contention_threads; ++t )
+    {
+        threads.emplace_back( [&shared, rounds, t]()
+        {
+            std::size_t found = 0;
+
+            for ( std::size_t i = 0; i < rounds * batch; ++i )
+            {
+                if ( t == 0 )
+                    shared.store( i % 8 ? nonstd::optional_bare::optional<T>( static_cast<T>( i ) ) : nonstd::optional_bare::optional<T>() );
+                else
+                    found += shared.load().has_value();
+            }
+            do_not_optimize( found );
+        } );
+    }
+
+    for ( auto & thread : threads )
+        thread.join();
+
+    return contention_threads * rounds * batch;
+}
+
+// read a value that is computed on first use, per operation: from a plain optional,
+// from an optional behind a mutex that is checked on every read, and from a
+// lazy_optional:
+
+inline int compute_answer()
+{
+    return 42;
+}
+
+std::size_t bm_lazy_plain( std::size_t rounds )
+{
+    nonstd::optional_bare::optional<int> value;
+    int sum = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        int round_sum = 0;
+
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            if ( ! value.has_value() )
+                value = nonstd::optional_bare::optional<int>( compute_answer() );
+
+            round_sum += *value;
+            do_not_optimize( value );
+        }
+        sum += round_sum;
+        do_not_optimize( sum );
+    }
+    return rounds * batch;
+}
+
+std::size_t bm_lazy_mutex( std::size_t rounds )
+{
+    std::mutex mutex;
+    nonstd::optional_bare::optional<int> value;
+    int sum = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        int round_sum = 0;
+
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            std::lock_guard<std::mutex> lock( mutex );
+
+            if ( ! value.has_value() )
+                value = nonstd::optional_bare::optional<int>( compute_answer() );
+
+            round_sum += *value;
+            do_not_optimize( value );
+        }
+        sum += round_sum;
+        do_not_optimize( sum );
+    }
+    return rounds * batch;
+}
+
+std::size_t bm_lazy_optional( std::size_t rounds )
+{
+    nonstd::lazy_optional<int> value( compute_answer );
+    int sum = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        int round_sum = 0;
+
+        // the acquire load of get() keeps the read in the loop:
+
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            round_sum += value.get();
+        }
+        sum += round_sum;
+        do_not_optimize( sum );
+    }
+    return rounds * batch;
+}
+
+#endif // optional_CPP11_OR_GREATER
+
+// sum of the engaged values, with a branch per element and with the
+// branch-free reductions over optionals and over a column:
+
+template< typename T >
+std::size_t bm_sum_branches( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        double s = 0;
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            if ( in[i] )
+                s += static_cast<double>( *in[i] );
+        }
+        do_not_optimize( s );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_sum_range( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        do_not_optimize( nonstd::optional_algorithm::sum( in.begin(), in.end() ) );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_sum_column( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    nonstd::optional_vector<T> column;
+
+    for ( std::size_t i = 0; i < batch; ++i )
+        column.push_back( in[i] );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        do_not_optimize( nonstd::optional_algorithm::sum( column ) );
+    }
+    return rounds * batch;
+}
+
+// copy the engaged values to a dense array, with a branch per element and
+// with the compaction of optionals and of a column:
+
+template< typename T >
+std::size_t bm_compact_branches( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector<T> out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        std::size_t k = 0;
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            if ( in[i] )
+                out[k++] = *in[i];
+        }
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_compact_range( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector<T> out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::compact( in.begin(), in.end(), out.begin() );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_compact_column( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    nonstd::optional_vector<T> column;
+    std::vector<T> out( batch );
+
+    for ( std::size_t i = 0; i < batch; ++i )
+        column.push_back( in[i] );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::compact( column, &out[0] );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+// element-wise addition with null propagation, with branches per element
+// and with the algorithms over optionals and over columns:
+
+template< typename T >
+std::size_t bm_add_branches( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector< nonstd::optional_bare::optional<T> > out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            std::size_t const j = batch - 1 - i;
+            out[i] = in[i] && in[j] ? nonstd::optional_bare::optional<T>( *in[i] + *in[j] ) : nonstd::optional_bare::optional<T>();
+        }
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_add_range( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector< nonstd::optional_bare::optional<T> > out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::add( in.begin(), in.end(), in.rbegin(), out.begin() );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_add_column( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    nonstd::optional_vector<T> a, b;
+
+    for ( std::size_t i = 0; i < batch; ++i )
+    {
+        a.push_back( in[i] );
+        b.push_back( in[ batch - 1 - i ] );
+    }
+
+    std::vector<T> out( batch );
+    std::vector<unsigned char> out_bitmap( batch / 8 );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::add( a.values(), a.bitmap(), b.values(), b.bitmap(), batch, &out[0], &out_bitmap[0] );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+// replace disengaged elements by a default, with value_or() per element
+// and with the algorithms over optionals and over a column:
+
+template< typename T >
+std::size_t bm_fill_value_or( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector<T> out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i )
+            out[i] = in[i].value_or( T( 42 ) );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_fill_range( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector<T> out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::fill_missing( in.begin(), in.end(), T( 42 ), out.begin() );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_fill_column( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    nonstd::optional_vector<T> column;
+    std::vector<T> out( batch );
+
+    for ( std::size_t i = 0; i < batch; ++i )
+        column.push_back( in[i] );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::fill_missing( column, T( 42 ), &out[0] );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+// carry the last engaged value forward, with has_value() per element and
+// with the algorithms over optionals and over a column:
+
+template< typename T >
+std::size_t bm_ffill_branches( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector< nonstd::optional_bare::optional<T> > out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_bare::optional<T> last;
+        for ( std::size_t i = 0; i < batch; ++i )
+        {
+            if ( in[i].has_value() )
+                last = in[i];
+            out[i] = last;
+        }
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_ffill_range( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    std::vector< nonstd::optional_bare::optional<T> > out( batch );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::ffill( in.begin(), in.end(), out.begin() );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+template< typename T >
+std::size_t bm_ffill_column( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = inputs< nonstd::optional_bare::optional, T >();
+    nonstd::optional_vector<T> column;
+    std::vector<T> out( batch );
+    std::vector<unsigned char> out_bitmap( batch / 8 );
+
+    for ( std::size_t i = 0; i < batch; ++i )
+        column.push_back( in[i] );
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        nonstd::optional_algorithm::ffill( column.values(), column.bitmap(), batch, &out[0], &out_bitmap[0] );
+        do_not_optimize( out );
+    }
+    return rounds * batch;
+}
+
+// sort 16 batches of optionals, half of them empty, with the disengaged elements
+// first: with std::sort of the optionals and with sort_optional(), by a comparison
+// and by std::less, which uses a radix sort:
+
+template< typename T >
+std::vector< nonstd::optional_bare::optional<T> > const & sort_inputs()
+{
+    static std::vector< nonstd::optional_bare::optional<T> > data;
+
+    if ( data.empty() )
+    {
+        lcg rnd( 11 );
+        for ( std::size_t i = 0; i < 16 * batch; ++i )
+            data.push_back( rnd() % 2 ? nonstd::optional_bare::optional<T>( make_value<T>( rnd() ) ) : nonstd::optional_bare::optional<T>() );
+    }
+    return data;
+}
+
+template< typename T >
+struct payload_less
+{
+    bool operator()( T const & a, T const & b ) const { return a < b; }
+};
+
+template< typename T >
+std::size_t bm_sort_optional_std( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = sort_inputs<T>();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        std::vector< nonstd::optional_bare::optional<T> > v( in );
+        std::sort( v.begin(), v.end() );
+        do_not_optimize( v );
+    }
+    return rounds * 16 * batch;
+}
+
+template< typename T >
+std::size_t bm_sort_optional_comparison( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = sort_inputs<T>();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        std::vector< nonstd::optional_bare::optional<T> > v( in );
+        nonstd::optional_algorithm::sort_optional( v.begin(), v.end(), nonstd::optional_algorithm::nulls_first, payload_less<T>() );
+        do_not_optimize( v );
+    }
+    return rounds * 16 * batch;
+}
+
+template< typename T >
+std::size_t bm_sort_optional_less( std::size_t rounds )
+{
+    std::vector< nonstd::optional_bare::optional<T> > const & in = sort_inputs<T>();
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        std::vector< nonstd::optional_bare::optional<T> > v( in );
+        nonstd::optional_algorithm::sort_optional( v.begin(), v.end() );
+        do_not_optimize( v );
+    }
+    return rounds * 16 * batch;
+}
+
+// look up a batch of keys, half of them present, in a map of 256K int keys:
+
+std::size_t const map_size = 256 * 1024;
+
+inline int map_key( std::size_t i )
+{
+    return static_cast<int>( i * 2654435761u % 0x7fffffffu );
+}
+
+template< typename Map >
+Map const & lookup_map()
+{
+    static Map m;
+
+    if ( m.empty() )
+    {
+        for ( std::size_t i = 0; i < map_size; ++i )
+            m[ map_key( 2 * i ) ] = static_cast<int>( i );
+    }
+    return m;
+}
+
+template< typename Map >
+std::size_t bm_lookup( std::size_t rounds )
+{
+    Map const & m = lookup_map<Map>();
+    std::size_t found = 0;
+    std::size_t k = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i, k = ( k + 7919 ) % ( 2 * map_size ) )
+            found += m.count( map_key( k ) );
+        do_not_optimize( found );
+    }
+    return rounds * batch;
+}
+
+// pools of entities of 32 bytes, of which every other one has been erased: a
+// vector of optionals with a separate free list, and a slot_map:
+
+std::size_t const pool_size = 64 * 1024;
+
+struct free_list_pool
+{
+    typedef std::size_t handle;
+
+    std::vector< nonstd::optional_bare::optional<blob32> > slots;
+    std::vector< std::size_t > free;
+
+    handle insert( blob32 const & value )
+    {
+        if ( free.empty() )
+        {
+            slots.push_back( value );
+            return slots.size() - 1;
+        }
+        std::size_t const i = free.back();
+        free.pop_back();
+        slots[i] = value;
+        return i;
+    }
+
+    void erase( handle i )
+    {
+        slots[i].reset();
+        free.push_back( i );
+    }
+
+    unsigned long sum() const
+    {
+        unsigned long result = 0;
+        for ( std::size_t i = 0; i < slots.size(); ++i )
+        {
+            if ( slots[i].has_value() )
+                result += slots[i]->data[0];
+        }
+        return result;
+    }
+};
+
+struct slot_map_pool : nonstd::slot_map<blob32>
+{
+    unsigned long sum() const
+    {
+        unsigned long result = 0;
+        for ( const_iterator pos = begin(); pos != end(); ++pos )
+            result += pos->data[0];
+        return result;
+    }
+};
+
+// pool with its handles to the live entities, in the order of the entities:
+
+template< typename Pool >
+struct pool_state
+{
+    Pool pool;
+    std::vector< typename Pool::handle > live;
+};
+
+template< typename Pool >
+pool_state<Pool> & pool()
+{
+    static pool_state<Pool> s;
+
+    if ( s.live.empty() )
+    {
+        std::vector< typename Pool::handle > h;
+
+        for ( std::size_t i = 0; i < pool_size; ++i )
+            h.push_back( s.pool.insert( make_value<blob32>( i ) ) );
+
+        // the odd multiplier permutes the indices, scattering the holes:
+
+        for ( std::size_t i = 0; i < pool_size; ++i )
+        {
+            std::size_t const k = i * 2654435761u % pool_size;
+
+            if ( i < pool_size / 2 )
+                s.pool.erase( h[k] );
+            else
+                s.live.push_back( h[k] );
+        }
+    }
+    return s;
+}
+
+// erase an entity and insert a new one per operation:
+
+template< typename Pool >
+std::size_t bm_churn( std::size_t rounds )
+{
+    pool_state<Pool> & s = pool<Pool>();
+    std::size_t k = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        for ( std::size_t i = 0; i < batch; ++i, k = ( k + 7919 ) % s.live.size() )
+        {
+            s.pool.erase( s.live[k] );
+            s.live[k] = s.pool.insert( make_value<blob32>( k ) );
+        }
+        do_not_optimize( s.live[k] );
+    }
+    return rounds * batch;
+}
+
+// visit the live entities, per operation:
+
+template< typename Pool >
+std::size_t bm_iterate( std::size_t rounds )
+{
+    Pool const & p = pool<Pool>().pool;
+    unsigned long result = 0;
+
+    for ( std::size_t r = 0; r < rounds; ++r )
+    {
+        result += p.sum();
+        do_not_optimize( result );
+    }
+    return rounds * pool_size / 2;
+}
+
+// register benchmarks for nonstd::optional and, if available, std::optional:
+
+#if optional_HAVE_STD_OPTIONAL
+# define optional_BENCH_ADD( name, bm, T ) \
+    add( name, #T, "nonstd", &bm< nonstd::optional_bare::optional, T > ); \
+    add( name, #T, "std"   , &bm< std::optional, T > )
+#else
+# define optional_BENCH_ADD( name, bm, T ) \
+    add( name, #T, "nonstd", &bm< nonstd::optional_bare::optional, T > )
+#endif
+
+#define optional_BENCH_ADD_TYPES( name, bm ) \
+    optional_BENCH_ADD( name, bm, int    ); \
+    optional_BENCH_ADD( name, bm, blob32 ); \
+    optional_BENCH_ADD( name, bm, std::string )
+
+struct registrar
+{
+    registrar()
+    {
+        optional_BENCH_ADD_TYPES( "construct empty", bm_construct_empty );
+        optional_BENCH_ADD_TYPES( "construct value", bm_construct_value );
+        optional_BENCH_ADD_TYPES( "copy"           , bm_copy            );
+        optional_BENCH_ADD_TYPES( "assign"         , bm_assign          );
+        optional_BENCH_ADD_TYPES( "swap"           , bm_swap            );
+        optional_BENCH_ADD_TYPES( "value_or"       , bm_value_or        );
+        optional_BENCH_ADD_TYPES( "compare"        , bm_compare         );
+        optional_BENCH_ADD_TYPES( "sort"           , bm_sort            );
+        optional_BENCH_ADD( "sort"        , bm_sort        , double );
+        add( "sum", "int"   , "branches", &bm_sum_branches<int>    );
+        add( "sum", "int"   , "range"   , &bm_sum_range<int>       );
+        add( "sum", "int"   , "column"  , &bm_sum_column<int>      );
+        add( "sum", "double", "branches", &bm_sum_branches<double> );
+        add( "sum", "double", "range"   , &bm_sum_range<double>    );
+        add( "sum", "double", "column"  , &bm_sum_column<double>   );
+        add( "compact", "int"   , "branches", &bm_compact_branches<int>    );
+        add( "compact", "int"   , "range"   , &bm_compact_range<int>       );
+        add( "compact", "int"   , "column"  , &bm_compact_column<int>      );
+        add( "compact", "double", "branches", &bm_compact_branches<double> );
+        add( "compact", "double", "range"   , &bm_compact_range<double>    );
+        add( "compact", "double", "column"  , &bm_compact_column<double>   );
+        add( "add"    , "int"   , "branches", &bm_add_branches<int>        );
+        add( "add"    , "int"   , "range"   , &bm_add_range<int>           );
+        add( "add"    , "int"   , "column"  , &bm_add_column<int>          );
+        add( "add"    , "double", "branches", &bm_add_branches<double>     );
+        add( "add"    , "double", "range"   , &bm_add_range<double>        );
+        add( "add"    , "double", "column"  , &bm_add_column<double>       );
+        add( "fill_missing", "int"   , "value_or", &bm_fill_value_or<int>    );
+        add( "fill_missing", "int"   , "range"   , &bm_fill_range<int>       );
+        add( "fill_missing", "int"   , "column"  , &bm_fill_column<int>      );
+        add( "fill_missing", "double", "value_or", &bm_fill_value_or<double> );
+        add( "fill_missing", "double", "range"   , &bm_fill_range<double>    );
+        add( "fill_missing", "double", "column"  , &bm_fill_column<double>   );
+        add( "ffill", "int"   , "branches", &bm_ffill_branches<int>    );
+        add( "ffill", "int"   , "range"   , &bm_ffill_range<int>       );
+        add( "ffill", "int"   , "column"  , &bm_ffill_column<int>      );
+        add( "ffill", "double", "branches", &bm_ffill_branches<double> );
+        add( "ffill", "double", "range"   , &bm_ffill_range<double>    );
+        add( "ffill", "double", "column"  , &bm_ffill_column<double>   );
+        add( "sort_optional", "int"   , "std::sort" , &bm_sort_optional_std<int>           );
+        add( "sort_optional", "int"   , "comparison", &bm_sort_optional_comparison<int>    );
+        add( "sort_optional", "int"   , "std::less" , &bm_sort_optional_less<int>          );
+        add( "sort_optional", "double", "std::sort" , &bm_sort_optional_std<double>        );
+        add( "sort_optional", "double", "comparison", &bm_sort_optional_comparison<double> );
+        add( "sort_optional", "double", "std::less" , &bm_sort_optional_less<double>       );
+        add( "lookup", "int", "std::map"         , &bm_lookup< std::map<int, int> >                   );
+#if optional_CPP11_OR_GREATER
+        add( "lookup", "int", "unordered_map"    , &bm_lookup< std::unordered_map<int, int> >         );
+#endif
+        add( "lookup", "int", "flat_optional_map", &bm_lookup< nonstd::flat_optional_map<int, int> > );
+        add( "pool churn"  , "blob32", "free list", &bm_churn  < free_list_pool > );
+        add( "pool churn"  , "blob32", "slot_map" , &bm_churn  < slot_map_pool  > );
+        add( "pool iterate", "blob32", "free list", &bm_iterate< free_list_pool > );
+        add( "pool iterate", "blob32", "slot_map" , &bm_iterate< slot_map_pool  > );
+#if optional_CPP11_OR_GREATER
+        optional_BENCH_ADD( "hash", bm_hash, int         );
+        optional_BENCH_ADD( "hash", bm_hash, std::string );
+        add( "and_then chain", "int", "branches", &bm_chain_branches );
+        add( "and_then chain", "int", "monadic" , &bm_chain_monadic  );
+        add( "fallback"      , "std::string", "value_or"     , &bm_fallback_value_or      );
+        add( "fallback"      , "std::string", "value_or_else", &bm_fallback_value_or_else );
+        add( "contention", "int"   , "mutex"          , &bm_contention< locked_optional<int>            , int    > );
+        add( "contention", "int"   , "atomic_optional", &bm_contention< nonstd::atomic_optional<int>    , int    > );
+        add( "contention", "double", "mutex"          , &bm_contention< locked_optional<double>         , double > );
+        add( "contention", "double", "atomic_optional", &bm_contention< nonstd::atomic_optional<double> , double > );
+        add( "lazy read", "int", "optional"     , &bm_lazy_plain    );
+        add( "lazy read", "int", "mutex"        , &bm_lazy_mutex    );
+        add( "lazy read", "int", "lazy_optional", &bm_lazy_optional );
+#endif
+    }
+} registrar_;
+
+#undef optional_BENCH_ADD_TYPES
+#undef optional_BENCH_ADD
+
+} // anonymous namespace
+
+// end of file
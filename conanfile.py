@@ -3,7 +3,7 @@ from conans import ConanFile, CMake
 class OptionalBareConan(ConanFile):
     version = "1.1.0"
     name = "optional-bare"
-    description = "A simple version of a C++17-like optional for default-constructible, copyable types, for C++98 and later in a single-file header-only library"
+    description = "A simple version of a C++17-like optional for copyable types, for C++98 and later in a single-file header-only library"
     license = "Boost Software License - Version 1.0. http://www.boost.org/LICENSE_1_0.txt"
     url = "https://github.com/martinmoene/optional-bare.git"
     exports_sources = "include/nonstd/*", "CMakeLists.txt", "cmake/*", "LICENSE.txt"
@@ -0,0 +1,286 @@
+//
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NONSTD_ATOMIC_OPTIONAL_HPP
+#define NONSTD_ATOMIC_OPTIONAL_HPP
+
+#include "nonstd/optional.hpp"
+
+#if optional_CPP11_OR_GREATER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace nonstd { namespace optional_bare {
+
+namespace detail {
+
+// atomic word of a payload of Size bytes and an engaged flag in its last byte:
+
+struct alignas( 16 ) atomic_word16
+{
+    unsigned char bytes[ 16 ];
+};
+
+template< std::size_t Size, bool = ( Size < sizeof( std::uint64_t ) ) >
+struct atomic_word
+{
+    typedef std::uint64_t type;
+};
+
+template< std::size_t Size >
+struct atomic_word< Size, false >
+{
+    static_assert( Size < sizeof( atomic_word16 ), "atomic_optional: payload must be smaller than 16 bytes" );
+
+    typedef atomic_word16 type;
+};
+
+// copy of the T in the first bytes of a word:
+
+template< typename T, typename W >
+T value_of( W const & w ) noexcept
+{
+    T value;
+    std::memcpy( &value, &w, sizeof( T ) );
+    return value;
+}
+
+// encoding of an optional<T> as a word with the payload in its first bytes and
+// an engaged flag in its last byte; an empty optional packs to all zero bits:
+
+template< typename T >
+struct flag_encoding
+{
+    typedef typename atomic_word< sizeof( T ) >::type word;
+
+    static word pack( optional<T> const & v ) noexcept
+    {
+        unsigned char bytes[ sizeof( word ) ] = {};
+
+        if ( v.has_value() )
+        {
+            std::memcpy( bytes, &*v, sizeof( T ) );
+            bytes[ sizeof( word ) - 1 ] = 1;
+        }
+
+        word w;
+        std::memcpy( &w, bytes, sizeof( word ) );
+        return w;
+    }
+
+    static optional<T> unpack( word const & w ) noexcept
+    {
+        unsigned char bytes[ sizeof( word ) ];
+        std::memcpy( bytes, &w, sizeof( word ) );
+
+        return bytes[ sizeof( word ) - 1 ] ? optional<T>( value_of<T>( w ) ) : optional<T>();
+    }
+};
+
+// encoding of an optional<T> of up to 8 bytes as a std::uint64_t that holds
+// the empty value of a compact_optional policy when the optional is empty:
+
+template< typename T, typename Policy >
+struct sentinel_encoding
+{
+    static_assert( sizeof( T ) <= sizeof( std::uint64_t ), "atomic_optional: payload with a policy must not be larger than 8 bytes" );
+
+    typedef std::uint64_t word;
+
+    static word pack( optional<T> const & v ) noexcept
+    {
+        T const value = v.has_value() ? *v : Policy::empty_value();
+
+        word w = 0;
+        std::memcpy( &w, &value, sizeof( T ) );
+        return w;
+    }
+
+    static optional<T> unpack( word const & w ) noexcept
+    {
+        T const value = value_of<T>( w );
+
+        return Policy::is_empty_value( value ) ? optional<T>() : optional<T>( value );
+    }
+};
+
+// encoding of an optional<T> of a 64-bit floating-point type as a std::uint64_t
+// that holds a reserved signaling NaN, which arithmetic never produces, when the
+// optional is empty; the reserved NaN is only handled as bits, as loading it as
+// a T may quiet it, as on x87:
+
+template< typename T >
+struct nan_encoding
+{
+    typedef std::uint64_t word;
+
+    static word empty_bits() noexcept
+    {
+        return 0x7ff4000000000001ull;
+    }
+
+    static word pack( optional<T> const & v ) noexcept
+    {
+        word w = empty_bits();
+
+        if ( v.has_value() )
+            std::memcpy( &w, &*v, sizeof( T ) );
+
+        return w;
+    }
+
+    static optional<T> unpack( word const & w ) noexcept
+    {
+        return w == empty_bits() ? optional<T>() : optional<T>( value_of<T>( w ) );
+    }
+};
+
+// default encoding: a reserved NaN for a 64-bit floating-point type, which
+// thus fits a lock-free std::uint64_t, and an engaged flag otherwise:
+
+template< typename T, typename Policy >
+struct atomic_encoding
+{
+    typedef sentinel_encoding<T, Policy> type;
+};
+
+template< typename T >
+struct atomic_encoding< T, void >
+{
+    typedef typename std::conditional<
+        std::is_floating_point<T>::value && std::numeric_limits<T>::is_iec559 && sizeof( T ) == sizeof( std::uint64_t ),
+        nan_encoding<T>,
+        flag_encoding<T>
+    >::type type;
+};
+
+} // namespace detail
+
+// Optional of a trivially copyable T, of which the state and the value change
+// atomically. The payload and the state are packed into one atomic word:
+// - a T of up to 7 bytes and an engaged flag into a std::uint64_t, which is
+//   lock-free on all common platforms,
+// - a double (a 64-bit IEEE floating-point T) into a std::uint64_t that holds
+//   a reserved signaling NaN when empty, so that it is lock-free as well,
+// - another T of up to 15 bytes and an engaged flag into a word of 16 bytes,
+//   which is lock-free only where the platform offers a double-width
+//   compare-and-swap (with GCC, such atomics call libatomic and are not lock-free),
+// - with a compact_optional Policy, a T of up to 8 bytes, such as std::int64_t,
+//   into a std::uint64_t that holds the reserved value of the policy when empty.
+// With C++17, is_always_lock_free tells which applies to T at compile time.
+// Note: T must be default constructible; storing the reserved value makes the
+// optional empty; like std::atomic, compare_exchange compares the object
+// representations, so T should not have padding bytes.
+
+template< typename T, typename Policy = void >
+class atomic_optional
+{
+    static_assert( std::is_trivially_copyable<T>::value, "atomic_optional: T must be trivially copyable" );
+    static_assert( std::is_default_constructible<T>::value, "atomic_optional: T must be default constructible" );
+
+    typedef typename detail::atomic_encoding<T, Policy>::type encoding;
+    typedef typename encoding::word word;
+
+public:
+    typedef T value_type;
+
+#if optional_CPP17_OR_GREATER
+    static constexpr bool is_always_lock_free = std::atomic< word >::is_always_lock_free;
+#endif
+
+    atomic_optional() noexcept
+    : word_( pack( optional<T>() ) )
+    {}
+
+    atomic_optional( optional<T> const & v ) noexcept
+    : word_( pack( v ) )
+    {}
+
+    atomic_optional( atomic_optional const & ) = delete;
+    atomic_optional & operator=( atomic_optional const & ) = delete;
+
+    bool is_lock_free() const noexcept
+    {
+        return word_.is_lock_free();
+    }
+
+    optional<T> load( std::memory_order order = std::memory_order_seq_cst ) const noexcept
+    {
+        return unpack( word_.load( order ) );
+    }
+
+    void store( optional<T> const & v, std::memory_order order = std::memory_order_seq_cst ) noexcept
+    {
+        word_.store( pack( v ), order );
+    }
+
+    optional<T> exchange( optional<T> const & v, std::memory_order order = std::memory_order_seq_cst ) noexcept
+    {
+        return unpack( word_.exchange( pack( v ), order ) );
+    }
+
+    // empty the optional and return its previous value:
+
+    optional<T> take( std::memory_order order = std::memory_order_seq_cst ) noexcept
+    {
+        return exchange( optional<T>(), order );
+    }
+
+    // replace expected by desired, or load the current value into expected:
+
+    bool compare_exchange_weak( optional<T> & expected, optional<T> const & desired, std::memory_order order = std::memory_order_seq_cst ) noexcept
+    {
+        word w = pack( expected );
+
+        if ( word_.compare_exchange_weak( w, pack( desired ), order ) )
+            return true;
+
+        expected = unpack( w );
+        return false;
+    }
+
+    bool compare_exchange_strong( optional<T> & expected, optional<T> const & desired, std::memory_order order = std::memory_order_seq_cst ) noexcept
+    {
+        word w = pack( expected );
+
+        if ( word_.compare_exchange_strong( w, pack( desired ), order ) )
+            return true;
+
+        expected = unpack( w );
+        return false;
+    }
+
+private:
+    static word pack( optional<T> const & v ) noexcept
+    {
+        return encoding::pack( v );
+    }
+
+    static optional<T> unpack( word const & w ) noexcept
+    {
+        return encoding::unpack( w );
+    }
+
+private:
+    std::atomic< word > word_;
+};
+
+} // namespace optional_bare
+
+using namespace optional_bare;
+
+} // namespace nonstd
+
+#endif // optional_CPP11_OR_GREATER
+
+#endif // NONSTD_ATOMIC_OPTIONAL_HPP
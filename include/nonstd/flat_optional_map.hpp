@@ -0,0 +1,676 @@
+//
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NONSTD_FLAT_OPTIONAL_MAP_HPP
+#define NONSTD_FLAT_OPTIONAL_MAP_HPP
+
+#include "nonstd/optional.hpp"
+
+// flat-optional-map configuration:
+
+// Disable the use of SSE2 intrinsics:
+
+#ifndef  optional_CONFIG_NO_SIMD
+# define optional_CONFIG_NO_SIMD  0
+#endif
+
+// Presence of SSE2, as selected by the compiler options:
+
+#ifndef optional_HAVE_SSE2
+# if ! optional_CONFIG_NO_SIMD && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#  define optional_HAVE_SSE2  1
+# else
+#  define optional_HAVE_SSE2  0
+# endif
+#endif
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if optional_CPP11_OR_GREATER
+# include <tuple>
+#endif
+
+#if optional_HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
+namespace nonstd { namespace optional_bare {
+
+namespace detail {
+
+// finalizer of MurmurHash3: every bit of h affects every bit of the result,
+// so that both the low bits that select a group and the high bits that are
+// stored as the control byte of a slot are well distributed:
+
+inline std::size_t mix_hash( unsigned long long h )
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return static_cast<std::size_t>( h );
+}
+
+} // namespace detail
+
+// default hash of flat_optional_map: std::hash with C++11 and later, and the
+// value of an integral key or the FNV-1a hash of a std::string with C++98;
+// the result is mixed, as std::hash of an integer often is the identity:
+
+template< typename K >
+struct flat_hash
+{
+    std::size_t operator()( K const & key ) const
+    {
+#if optional_CPP11_OR_GREATER
+        return detail::mix_hash( std::hash<K>()( key ) );
+#else
+        return detail::mix_hash( static_cast<unsigned long long>( key ) );
+#endif
+    }
+};
+
+#if ! optional_CPP11_OR_GREATER
+template<>
+struct flat_hash< std::string >
+{
+    std::size_t operator()( std::string const & key ) const
+    {
+        unsigned long long h = 0xcbf29ce484222325ull;
+        for ( std::string::size_type i = 0; i < key.size(); ++i )
+            h = ( h ^ static_cast<unsigned char>( key[i] ) ) * 0x100000001b3ull;
+        return detail::mix_hash( h );
+    }
+};
+#endif
+
+namespace detail {
+
+// control bytes of a flat_optional_map: a full slot holds the low seven bits
+// of the hash of its key, an empty or deleted slot has the sign bit set:
+
+signed char const ctrl_empty   = -128;
+signed char const ctrl_deleted = -2;
+
+// a group of 16 control bytes, matched at once, with a bit per byte in the result:
+
+struct ctrl_group
+{
+    enum { width = 16 };
+
+#if optional_HAVE_SSE2
+    __m128i ctrl;
+
+    explicit ctrl_group( signed char const * p )
+    : ctrl( _mm_loadu_si128( reinterpret_cast<__m128i const *>( p ) ) )
+    {}
+
+    unsigned int match( signed char h2 ) const
+    {
+        return static_cast<unsigned int>( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_set1_epi8( h2 ), ctrl ) ) );
+    }
+
+    unsigned int match_empty() const
+    {
+        return match( ctrl_empty );
+    }
+
+    unsigned int match_empty_or_deleted() const
+    {
+        return static_cast<unsigned int>( _mm_movemask_epi8( ctrl ) );
+    }
+#else
+    signed char const * ctrl;
+
+    explicit ctrl_group( signed char const * p )
+    : ctrl( p )
+    {}
+
+    unsigned int match( signed char h2 ) const
+    {
+        unsigned int m = 0;
+        for ( unsigned int i = 0; i < width; ++i )
+            m |= static_cast<unsigned int>( ctrl[i] == h2 ) << i;
+        return m;
+    }
+
+    unsigned int match_empty() const
+    {
+        return match( ctrl_empty );
+    }
+
+    unsigned int match_empty_or_deleted() const
+    {
+        unsigned int m = 0;
+        for ( unsigned int i = 0; i < width; ++i )
+            m |= static_cast<unsigned int>( ctrl[i] < 0 ) << i;
+        return m;
+    }
+#endif
+};
+
+// index of the lowest set bit of a non-zero mask:
+
+inline std::size_t lowest_bit( unsigned int m )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast<std::size_t>( __builtin_ctz( m ) );
+#else
+    std::size_t n = 0;
+    for ( ; ! ( m & 1u ); m >>= 1 )
+        ++n;
+    return n;
+#endif
+}
+
+} // namespace detail
+
+// Open-addressing hash map that stores its elements inline in slots of
+// optional<std::pair<K, V>>, without an allocation per element. As in SwissTable,
+// a control byte per slot holds seven bits of the hash of a full slot, and a
+// lookup compares the control bytes of a group of 16 slots at once (with SSE2
+// when available) before it compares keys. The number of slots is a power of
+// two, probed a group at a time, and the map grows at a load of 7/8.
+// Note: requires K and V to be copyable with C++98 and movable with C++11; an
+// insertion that throws leaves the elements unchanged; erase() leaves a tombstone
+// that is reclaimed when the table is rehashed, and modification invalidates iterators.
+
+template< typename K, typename V, typename Hash = flat_hash<K>, typename KeyEqual = std::equal_to<K> >
+class flat_optional_map
+{
+public:
+    typedef K                   key_type;
+    typedef V                   mapped_type;
+    typedef std::pair<K, V>     value_type;
+    typedef std::size_t         size_type;
+    typedef Hash                hasher;
+    typedef KeyEqual            key_equal;
+
+    // forward iterator over the elements, in the order of their slots:
+
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag   iterator_category;
+        typedef std::pair<K, V>             value_type;
+        typedef std::ptrdiff_t              difference_type;
+        typedef value_type const &          reference;
+        typedef value_type const *          pointer;
+
+        const_iterator()
+        : m_( 0 ), i_( 0 )
+        {}
+
+        const_iterator( flat_optional_map const * m, size_type i )
+        : m_( m ), i_( m->next_full( i ) )
+        {}
+
+        reference operator*() const { return *m_->slots_[ i_ ]; }
+        pointer operator->() const { return &*m_->slots_[ i_ ]; }
+
+        const_iterator & operator++() { i_ = m_->next_full( i_ + 1 ); return *this; }
+        const_iterator operator++( int ) { const_iterator tmp( *this ); ++*this; return tmp; }
+
+        friend bool operator==( const_iterator const & a, const_iterator const & b ) { return a.i_ == b.i_; }
+        friend bool operator!=( const_iterator const & a, const_iterator const & b ) { return a.i_ != b.i_; }
+
+    private:
+        flat_optional_map const * m_;
+        size_type i_;
+    };
+
+    typedef const_iterator iterator;
+
+    // construction of an empty map, with room for n elements:
+
+    flat_optional_map()
+    : size_( 0 ), growth_left_( 0 )
+    {}
+
+    explicit flat_optional_map( size_type n, Hash const & hash = Hash(), KeyEqual const & equal = KeyEqual() )
+    : size_( 0 ), growth_left_( 0 ), hash_( hash ), equal_( equal )
+    {
+        reserve( n );
+    }
+
+    // iterators
+
+    const_iterator begin() const
+    {
+        return const_iterator( this, 0 );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( this, capacity() );
+    }
+
+    // capacity
+
+    size_type size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    // number of slots:
+
+    size_type capacity() const
+    {
+        return slots_.size();
+    }
+
+    // make room for n elements without a rehash:
+
+    void reserve( size_type n )
+    {
+        if ( n > size_ + growth_left_ )
+            rehash( capacity_for( n ) );
+    }
+
+    // lookup
+
+    bool contains( K const & key ) const
+    {
+        return find_index( key ) != npos();
+    }
+
+    size_type count( K const & key ) const
+    {
+        return contains( key ) ? 1 : 0;
+    }
+
+    // copy of the value of a key:
+
+    optional<V> get( K const & key ) const
+    {
+        size_type const i = find_index( key );
+        return i != npos() ? optional<V>( slots_[ i ]->second ) : optional<V>();
+    }
+
+#if ! optional_USES_STD_OPTIONAL
+    // reference to the value of a key, without copying it:
+
+    optional<V &> find( K const & key )
+    {
+        size_type const i = find_index( key );
+        return i != npos() ? optional<V &>( slots_[ i ]->second ) : optional<V &>();
+    }
+
+    optional<V const &> find( K const & key ) const
+    {
+        size_type const i = find_index( key );
+        return i != npos() ? optional<V const &>( slots_[ i ]->second ) : optional<V const &>();
+    }
+#endif
+
+    // modifiers
+
+    // insert a key with a value if the key is not present; return whether it was inserted:
+
+#if optional_CPP11_OR_GREATER
+
+    bool insert( K const & key, V const & value )
+    {
+        return try_emplace_index( key, value ).second;
+    }
+
+    bool insert( K && key, V && value )
+    {
+        return try_emplace_index( std::move( key ), std::move( value ) ).second;
+    }
+
+    // insert a key with a value constructed in place from args if the key is not present;
+    // return whether it was inserted, the arguments are not used if it was not:
+
+    template< typename... Args >
+    bool try_emplace( K const & key, Args&&... args )
+    {
+        return try_emplace_index( key, std::forward<Args>( args )... ).second;
+    }
+
+    template< typename... Args >
+    bool try_emplace( K && key, Args&&... args )
+    {
+        return try_emplace_index( std::move( key ), std::forward<Args>( args )... ).second;
+    }
+
+    // insert an element constructed from args if its key is not present;
+    // return whether it was inserted:
+
+    template< typename... Args >
+    bool emplace( Args&&... args )
+    {
+        value_type value( std::forward<Args>( args )... );
+        return try_emplace_index( std::move( value.first ), std::move( value.second ) ).second;
+    }
+
+    // insert a key with a value, or assign the value to a present key:
+
+    void insert_or_assign( K const & key, V const & value )
+    {
+        std::pair<size_type, bool> const r = try_emplace_index( key, value );
+        if ( ! r.second )
+            slots_[ r.first ]->second = value;
+    }
+
+    void insert_or_assign( K && key, V && value )
+    {
+        size_type const i = find_index( key );
+        if ( i != npos() )
+            slots_[ i ]->second = std::move( value );
+        else
+            try_emplace_index( std::move( key ), std::move( value ) );
+    }
+
+    // reference to the value of a key, inserting a value-initialized V if the key is not present:
+
+    V & operator[]( K const & key )
+    {
+        return slots_[ try_emplace_index( key ).first ]->second;
+    }
+
+    V & operator[]( K && key )
+    {
+        return slots_[ try_emplace_index( std::move( key ) ).first ]->second;
+    }
+
+#else // optional_CPP11_OR_GREATER
+
+    bool insert( K const & key, V const & value )
+    {
+        std::size_t const h = hash_( key );
+
+        if ( find_index( key, h ) != npos() )
+            return false;
+
+        size_type const i = prepare_insert( h );
+        slots_[ i ].emplace( key, value );
+        commit_insert( i, h );
+        return true;
+    }
+
+    // insert a key with a value, or assign the value to a present key:
+
+    void insert_or_assign( K const & key, V const & value )
+    {
+        size_type const i = find_index( key );
+        if ( i != npos() )
+            slots_[ i ]->second = value;
+        else
+            insert( key, value );
+    }
+
+    // reference to the value of a key, inserting a value-initialized V if the key is not present:
+
+    V & operator[]( K const & key )
+    {
+        std::size_t const h = hash_( key );
+        size_type i = find_index( key, h );
+
+        if ( i == npos() )
+        {
+            i = prepare_insert( h );
+            slots_[ i ].emplace( key, V() );
+            commit_insert( i, h );
+        }
+        return slots_[ i ]->second;
+    }
+
+#endif // optional_CPP11_OR_GREATER
+
+    // remove a key; return the number of elements removed:
+
+    size_type erase( K const & key )
+    {
+        size_type const i = find_index( key );
+
+        if ( i == npos() )
+            return 0;
+
+        slots_[ i ].reset();
+        set_ctrl( i, detail::ctrl_deleted );
+        --size_;
+        return 1;
+    }
+
+    void clear()
+    {
+        for ( size_type i = 0; i < capacity(); ++i )
+        {
+            if ( ctrl_[ i ] >= 0 )
+                slots_[ i ].reset();
+        }
+        std::fill( ctrl_.begin(), ctrl_.end(), detail::ctrl_empty );
+        size_ = 0;
+        growth_left_ = max_load( capacity() );
+    }
+
+    void swap( flat_optional_map & other )
+    {
+        using std::swap;
+        ctrl_.swap( other.ctrl_ );
+        slots_.swap( other.slots_ );
+        swap( size_, other.size_ );
+        swap( growth_left_, other.growth_left_ );
+        swap( hash_, other.hash_ );
+        swap( equal_, other.equal_ );
+    }
+
+private:
+    typedef detail::ctrl_group group;
+
+    static size_type npos()
+    {
+        return static_cast<size_type>( -1 );
+    }
+
+    // elements that fit in a number of slots at a load of 7/8:
+
+    static size_type max_load( size_type slots )
+    {
+        return slots - slots / 8;
+    }
+
+    // number of slots for n elements, a power of two of at least a group:
+
+    static size_type capacity_for( size_type n )
+    {
+        size_type slots = group::width;
+        while ( max_load( slots ) < n )
+            slots *= 2;
+        return slots;
+    }
+
+    static signed char h2( std::size_t h )
+    {
+        return static_cast<signed char>( h & 0x7f );
+    }
+
+    // index of the full slot at or after slot i, or capacity():
+
+    size_type next_full( size_type i ) const
+    {
+        while ( i < capacity() && ctrl_[ i ] < 0 )
+            ++i;
+        return i;
+    }
+
+    // the control bytes of the first group are mirrored after the last slot,
+    // so that a group can be loaded at any slot:
+
+    void set_ctrl( size_type i, signed char c )
+    {
+        ctrl_[ i ] = c;
+        if ( i < group::width )
+            ctrl_[ capacity() + i ] = c;
+    }
+
+    size_type find_index( K const & key ) const
+    {
+        return find_index( key, hash_( key ) );
+    }
+
+    // probe the groups from slot h >> 7 on, with a step that grows by a group,
+    // which visits every group of a table of a power of two groups:
+
+    size_type find_index( K const & key, std::size_t h ) const
+    {
+        if ( capacity() == 0 )
+            return npos();
+
+        size_type const mask = capacity() - 1;
+        size_type pos = ( h >> 7 ) & mask;
+
+        for ( size_type step = group::width; ; step += group::width )
+        {
+            group const g( &ctrl_[ pos ] );
+
+            for ( unsigned int m = g.match( h2( h ) ); m != 0; m &= m - 1 )
+            {
+                size_type const i = ( pos + detail::lowest_bit( m ) ) & mask;
+                if ( equal_( slots_[ i ]->first, key ) )
+                    return i;
+            }
+
+            if ( g.match_empty() != 0 )
+                return npos();
+
+            pos = ( pos + step ) & mask;
+        }
+    }
+
+    // first empty or deleted slot of the probe sequence of hash h:
+
+    size_type find_free( std::size_t h ) const
+    {
+        size_type const mask = capacity() - 1;
+        size_type pos = ( h >> 7 ) & mask;
+
+        for ( size_type step = group::width; ; step += group::width )
+        {
+            unsigned int const m = group( &ctrl_[ pos ] ).match_empty_or_deleted();
+
+            if ( m != 0 )
+                return ( pos + detail::lowest_bit( m ) ) & mask;
+
+            pos = ( pos + step ) & mask;
+        }
+    }
+
+    // find a free slot for a new element of hash h, growing the table if needed;
+    // the slot is only marked full by commit_insert(), once its element is constructed:
+
+    size_type prepare_insert( std::size_t h )
+    {
+        size_type i = capacity() > 0 ? find_free( h ) : npos();
+
+        if ( i == npos() || ( growth_left_ == 0 && ctrl_[ i ] != detail::ctrl_deleted ) )
+        {
+            rehash( capacity_for( size_ + 1 ) );
+            i = find_free( h );
+        }
+        return i;
+    }
+
+    // mark slot i full with an element of hash h; a deleted slot is reused without consuming growth:
+
+    void commit_insert( size_type i, std::size_t h )
+    {
+        if ( ctrl_[ i ] == detail::ctrl_empty )
+            --growth_left_;
+
+        set_ctrl( i, h2( h ) );
+        ++size_;
+    }
+
+#if optional_CPP11_OR_GREATER
+    // index of the element of a key, constructing its value in place from args if
+    // the key is not present, and whether it was inserted:
+
+    template< typename KArg, typename... Args >
+    std::pair<size_type, bool> try_emplace_index( KArg && key, Args&&... args )
+    {
+        std::size_t const h = hash_( key );
+        size_type const i = find_index( key, h );
+
+        if ( i != npos() )
+            return std::pair<size_type, bool>( i, false );
+
+        size_type const k = prepare_insert( h );
+        slots_[ k ].emplace( std::piecewise_construct,
+            std::forward_as_tuple( std::forward<KArg>( key ) ), std::forward_as_tuple( std::forward<Args>( args )... ) );
+        commit_insert( k, h );
+        return std::pair<size_type, bool>( k, true );
+    }
+#endif
+
+    // move the elements to a table of the given number of slots, dropping tombstones;
+    // the elements are copied if moving them may throw, so that a throw leaves this map intact:
+
+    void rehash( size_type slots )
+    {
+        flat_optional_map tmp;
+
+        tmp.ctrl_.assign( slots + group::width, detail::ctrl_empty );
+        tmp.slots_.resize( slots );
+        tmp.growth_left_ = max_load( slots );
+        tmp.hash_ = hash_;
+        tmp.equal_ = equal_;
+
+        for ( size_type i = 0; i < capacity(); ++i )
+        {
+            if ( ctrl_[ i ] < 0 )
+                continue;
+
+            std::size_t const h = hash_( slots_[ i ]->first );
+            size_type const k = tmp.find_free( h );
+
+#if optional_CPP11_OR_GREATER
+            tmp.slots_[ k ].emplace( std::move_if_noexcept( *slots_[ i ] ) );
+#else
+            tmp.slots_[ k ].emplace( *slots_[ i ] );
+#endif
+            tmp.commit_insert( k, h );
+        }
+        swap( tmp );
+    }
+
+private:
+    std::vector< signed char > ctrl_;
+    std::vector< optional<value_type> > slots_;
+    size_type size_;
+    size_type growth_left_;
+    Hash hash_;
+    KeyEqual equal_;
+};
+
+template< typename K, typename V, typename H, typename E >
+void swap( flat_optional_map<K, V, H, E> & x, flat_optional_map<K, V, H, E> & y )
+{
+    x.swap( y );
+}
+
+} // namespace optional_bare
+
+using namespace optional_bare;
+
+} // namespace nonstd
+
+#endif // NONSTD_FLAT_OPTIONAL_MAP_HPP
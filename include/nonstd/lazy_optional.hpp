@@ -0,0 +1,197 @@
+//
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NONSTD_LAZY_OPTIONAL_HPP
+#define NONSTD_LAZY_OPTIONAL_HPP
+
+#include "nonstd/optional.hpp"
+
+#if optional_CPP11_OR_GREATER
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace nonstd { namespace optional_bare {
+
+// Optional that threads initialize once, on first use (C++11). A read of an
+// initialized value costs a single acquire load of the state in addition to
+// reading the optional. Otherwise, the first thread marks the state busy under
+// the mutex and runs the initializer without holding it, while other threads
+// wait on the condition variable. If the initializer throws, the optional stays
+// empty and a later call initializes it again. The value is constructed in place
+// from the result of the initializer.
+
+template< typename T >
+class lazy_optional;
+
+template< typename T >
+class once_optional
+{
+public:
+    typedef T value_type;
+
+    once_optional()
+    : state_( empty )
+    {}
+
+    ~once_optional()
+    {
+        if ( has_value() )
+            storage_.value.~T();
+    }
+
+    once_optional( once_optional const & ) = delete;
+    once_optional & operator=( once_optional const & ) = delete;
+
+    bool has_value() const noexcept
+    {
+        return state_.load( std::memory_order_acquire ) == ready;
+    }
+
+#if ! optional_USES_STD_OPTIONAL
+    // reference to the value, or nullopt if not yet initialized:
+
+    optional<T const &> try_get() const noexcept
+    {
+        return has_value() ? optional<T const &>( storage_.value ) : optional<T const &>();
+    }
+#endif
+
+    // the value, initialized to init() by the first call:
+
+    template< typename F >
+    T const & get_or_init( F && init )
+    {
+        if ( has_value() )
+            return storage_.value;
+
+        return initialize( std::forward<F>( init ), []{} );
+    }
+
+private:
+    friend class lazy_optional<T>;
+
+    enum state_type { empty, busy, ready };
+
+    // storage of the value, constructed once the state becomes ready:
+
+    union storage
+    {
+        storage() {}
+        ~storage() {}
+
+        T value;
+    };
+
+    // on scope exit unless dismissed, return to empty after a failed initialization:
+
+    struct reset_guard
+    {
+        once_optional * self;
+
+        explicit reset_guard( once_optional & x ) : self( &x ) {}
+
+        ~reset_guard()
+        {
+            if ( self )
+            {
+                std::lock_guard< std::mutex > lock( self->mutex_ );
+                self->state_.store( empty, std::memory_order_relaxed );
+                self->ready_.notify_all();
+            }
+        }
+
+        void dismiss() { self = nullptr; }
+    };
+
+    // initialize the value to init() unless another thread did, and run done(),
+    // which must not throw, in the initializing thread after it succeeded:
+
+    template< typename F, typename G >
+    T const & initialize( F && init, G && done )
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+
+        while ( state_.load( std::memory_order_relaxed ) == busy )
+            ready_.wait( lock );
+
+        if ( state_.load( std::memory_order_relaxed ) == ready )
+            return storage_.value;
+
+        state_.store( busy, std::memory_order_relaxed );
+        lock.unlock();
+
+        reset_guard guard( *this );
+        ::new( static_cast<void *>( &storage_.value ) ) T( init() );
+        guard.dismiss();
+        done();
+
+        lock.lock();
+        state_.store( ready, std::memory_order_release );
+        ready_.notify_all();
+        return storage_.value;
+    }
+
+private:
+    std::atomic< unsigned char > state_;
+    storage storage_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+};
+
+// once_optional with its initializer, which runs on the first call of get() and
+// is released once the value is initialized, with everything it captured:
+
+template< typename T >
+class lazy_optional
+{
+public:
+    typedef T value_type;
+
+    explicit lazy_optional( std::function< T() > init )
+    : init_( std::move( init ) )
+    {}
+
+    bool has_value() const noexcept
+    {
+        return value_.has_value();
+    }
+
+#if ! optional_USES_STD_OPTIONAL
+    optional<T const &> try_get() const noexcept
+    {
+        return value_.try_get();
+    }
+#endif
+
+    T const & get()
+    {
+        if ( value_.has_value() )
+            return value_.storage_.value;
+
+        return value_.initialize( init_, [this]{ init_ = nullptr; } );
+    }
+
+private:
+    std::function< T() > init_;
+    once_optional<T> value_;
+};
+
+} // namespace optional_bare
+
+using namespace optional_bare;
+
+} // namespace nonstd
+
+#endif // optional_CPP11_OR_GREATER
+
+#endif // NONSTD_LAZY_OPTIONAL_HPP
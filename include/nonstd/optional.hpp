@@ -63,447 +63,1765 @@
 
 #define optional_CPLUSPLUS_V  ( optional_CPLUSPLUS / 100 - (optional_CPLUSPLUS > 200000 ? 2000 : 1994) )
 
+// Presence of C++11 and relaxed C++14 constexpr:
+
+#if optional_CPP11_OR_GREATER
+# define optional_constexpr  constexpr
+#else
+# define optional_constexpr  /*constexpr*/
+#endif
+
+#if optional_CPP14_OR_GREATER
+# define optional_constexpr14  constexpr
+#else
+# define optional_constexpr14  /*constexpr*/
+#endif
+
+// Presence of C++20 three-way comparison:
+
+#if optional_CPP20_OR_GREATER && defined( __cpp_impl_three_way_comparison )
+# define optional_HAVE_THREE_WAY_COMPARISON  1
+#else
+# define optional_HAVE_THREE_WAY_COMPARISON  0
+#endif
+
 // Use C++17 std::optional if available and requested:
 
-#if optional_CPP17_OR_GREATER && defined(__has_include )
-# if __has_include( <optional> )
-#  define optional_HAVE_STD_OPTIONAL  1
-# else
-#  define optional_HAVE_STD_OPTIONAL  0
-# endif
-#else
-# define  optional_HAVE_STD_OPTIONAL  0
-#endif
+#if optional_CPP17_OR_GREATER && defined(__has_include )
+# if __has_include( <optional> )
+#  define optional_HAVE_STD_OPTIONAL  1
+# else
+#  define optional_HAVE_STD_OPTIONAL  0
+# endif
+#else
+# define  optional_HAVE_STD_OPTIONAL  0
+#endif
+
+#define optional_USES_STD_OPTIONAL  ( (optional_CONFIG_SELECT_OPTIONAL == optional_OPTIONAL_STD) || ((optional_CONFIG_SELECT_OPTIONAL == optional_OPTIONAL_DEFAULT) && optional_HAVE_STD_OPTIONAL) )
+
+//
+// Using std::optional:
+//
+
+#if optional_USES_STD_OPTIONAL
+
+#include <optional>
+#include <utility>
+
+namespace nonstd {
+
+    using std::in_place;
+    using std::in_place_type;
+    using std::in_place_index;
+    using std::in_place_t;
+    using std::in_place_type_t;
+    using std::in_place_index_t;
+
+    using std::optional;
+    using std::bad_optional_access;
+    using std::hash;
+
+    using std::nullopt;
+    using std::nullopt_t;
+
+    using std::operator==;
+    using std::operator!=;
+    using std::operator<;
+    using std::operator<=;
+    using std::operator>;
+    using std::operator>=;
+#if optional_HAVE_THREE_WAY_COMPARISON
+    using std::operator<=>;
+#endif
+    using std::make_optional;
+    using std::swap;
+}
+
+#else // optional_USES_STD_OPTIONAL
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+#if ! optional_CONFIG_NO_EXCEPTIONS
+# include <stdexcept>
+#endif
+
+#if optional_CPP11_OR_GREATER
+# include <type_traits>
+# include <utility>
+#endif
+
+#if optional_HAVE_THREE_WAY_COMPARISON
+# include <compare>
+#endif
+
+namespace nonstd { namespace optional_bare {
+
+// type for nullopt
+
+struct nullopt_t
+{
+    struct init{};
+    optional_constexpr nullopt_t( init ) {}
+};
+
+// extra parenthesis to prevent the most vexing parse:
+
+optional_constexpr const nullopt_t nullopt(( nullopt_t::init() ));
+
+// type and tag for in-place construction:
+
+struct in_place_t
+{
+    optional_constexpr explicit in_place_t() {}
+};
+
+optional_constexpr const in_place_t in_place = in_place_t();
+
+// optional access error.
+
+#if ! optional_CONFIG_NO_EXCEPTIONS
+
+class bad_optional_access : public std::logic_error
+{
+public:
+  explicit bad_optional_access()
+  : logic_error( "bad optional access" ) {}
+};
+
+#endif // optional_CONFIG_NO_EXCEPTIONS
+
+namespace detail {
+
+// C++98 alignment of a type:
+
+template< typename T >
+struct alignment_of_hack
+{
+    char c;
+    T t;
+    alignment_of_hack();
+};
+
+template< std::size_t A, std::size_t S >
+struct alignment_logic
+{
+    static const std::size_t value = A < S ? A : S;
+};
+
+template< typename T >
+struct alignment_of
+{
+    static const std::size_t value = alignment_logic< sizeof( alignment_of_hack<T> ) - sizeof( T ), sizeof( T ) >::value;
+};
+
+template< bool C, typename T, typename F >
+struct select { typedef T type; };
+
+template< typename T, typename F >
+struct select< false, T, F > { typedef F type; };
+
+template< typename T >
+struct remove_const { typedef T type; };
+
+template< typename T >
+struct remove_const< T const > { typedef T type; };
+
+// type with maximum alignment, used when no fundamental type matches:
+
+union max_align_t
+{
+    char c;
+    short s;
+    int i;
+    long l;
+    float f;
+    double d;
+    long double ld;
+    void * p;
+    void (*pf)();
+};
+
+// fundamental type with the alignment of T:
+
+template< typename T >
+struct aligned_type
+{
+    static const std::size_t A = alignment_of<T>::value;
+
+    typedef typename select< A == alignment_of< char        >::value, char,
+            typename select< A == alignment_of< short       >::value, short,
+            typename select< A == alignment_of< int         >::value, int,
+            typename select< A == alignment_of< long        >::value, long,
+            typename select< A == alignment_of< double      >::value, double,
+            typename select< A == alignment_of< long double >::value, long double,
+                             max_align_t
+            >::type >::type >::type >::type >::type >::type type;
+};
+
+#if optional_CPP11_OR_GREATER
+
+// storage for a T as variant member of a union, so that the value can be created
+// in a constant expression; the union is trivially destructible if T is:
+
+template< typename T, bool = std::is_trivially_destructible<T>::value >
+union storage_union
+{
+    constexpr storage_union()
+    : dummy_()
+    {}
+
+    template< typename... Args >
+    constexpr explicit storage_union( in_place_t, Args&&... args )
+    : value_( std::forward<Args>( args )... )
+    {}
+
+    unsigned char dummy_;
+    T value_;
+};
+
+template< typename T >
+union storage_union< T, false >
+{
+    constexpr storage_union()
+    : dummy_()
+    {}
+
+    template< typename... Args >
+    constexpr explicit storage_union( in_place_t, Args&&... args )
+    : value_( std::forward<Args>( args )... )
+    {}
+
+    ~storage_union() {}
+
+    unsigned char dummy_;
+    T value_;
+};
+
+// uninitialized storage for a T, the value is created via constexpr construction
+// or via placement-new:
+
+template< typename T >
+class storage_t
+{
+public:
+    constexpr storage_t()
+    : data_()
+    {}
+
+    template< typename... Args >
+    constexpr explicit storage_t( in_place_t, Args&&... args )
+    : data_( in_place, std::forward<Args>( args )... )
+    {}
+
+    void * ptr()
+    {
+        return &data_.value_;
+    }
+
+    void const * ptr() const
+    {
+        return &data_.value_;
+    }
+
+    optional_constexpr14 T & value()
+    {
+        return data_.value_;
+    }
+
+    constexpr T const & value() const
+    {
+        return data_.value_;
+    }
+
+    template< typename... Args >
+    void construct_value( Args&&... args )
+    {
+        ::new( ptr() ) T( std::forward<Args>( args )... );
+    }
+
+    void destruct_value()
+    {
+        value().~T();
+    }
+
+private:
+    storage_union< T > data_;
+};
+
+#else // optional_CPP11_OR_GREATER
+
+// uninitialized storage for a T, the value is created via placement-new:
+
+template< typename T >
+class storage_t
+{
+public:
+    void * ptr()
+    {
+        return &data_;
+    }
+
+    void const * ptr() const
+    {
+        return &data_;
+    }
+
+    T & value()
+    {
+        return *static_cast<T *>( ptr() );
+    }
+
+    T const & value() const
+    {
+        return *static_cast<T const *>( ptr() );
+    }
+
+    void construct_value()
+    {
+        ::new( ptr() ) T();
+    }
+
+    template< typename A1 >
+    void construct_value( A1 const & a1 )
+    {
+        ::new( ptr() ) T( a1 );
+    }
+
+    template< typename A1, typename A2 >
+    void construct_value( A1 const & a1, A2 const & a2 )
+    {
+        ::new( ptr() ) T( a1, a2 );
+    }
+
+    template< typename A1, typename A2, typename A3 >
+    void construct_value( A1 const & a1, A2 const & a2, A3 const & a3 )
+    {
+        ::new( ptr() ) T( a1, a2, a3 );
+    }
+
+    void destruct_value()
+    {
+        value().~T();
+    }
+
+private:
+    union
+    {
+        typename aligned_type<T>::type align_;
+        unsigned char data_[ sizeof( T ) ];
+    };
+};
+
+#endif // optional_CPP11_OR_GREATER
+
+// engaged state and storage, without copy, move and destruction semantics;
+// a recycled value is disengaged, but kept alive so that it can be reused:
+
+template< typename T >
+class optional_storage_base
+{
+public:
+    optional_constexpr optional_storage_base()
+    : state_( empty_state )
+    {}
+
+#if optional_CPP11_OR_GREATER
+    template< typename... Args >
+    constexpr explicit optional_storage_base( in_place_t, Args&&... args )
+    : state_( engaged_state )
+    , contained( in_place, std::forward<Args>( args )... )
+    {}
+#endif
+
+    optional_constexpr bool has_value() const
+    {
+        return state_ == engaged_state;
+    }
+
+    bool has_object() const
+    {
+        return state_ != empty_state;
+    }
+
+    optional_constexpr14 T & value()
+    {
+        return contained.value();
+    }
+
+    optional_constexpr T const & value() const
+    {
+        return contained.value();
+    }
+
+#if optional_CPP11_OR_GREATER
+    template< typename... Args >
+    void initialize( Args&&... args )
+    {
+        assert( ! has_object() );
+        contained.construct_value( std::forward<Args>( args )... );
+        state_ = engaged_state;
+    }
+
+    template< typename V >
+    void assign_value( V && v )
+    {
+        if ( has_object() ) { value() = std::forward<V>( v ); state_ = engaged_state; }
+        else                initialize( std::forward<V>( v ) );
+    }
+#else
+    void initialize()
+    {
+        assert( ! has_object() );
+        contained.construct_value();
+        state_ = engaged_state;
+    }
+
+    template< typename A1 >
+    void initialize( A1 const & a1 )
+    {
+        assert( ! has_object() );
+        contained.construct_value( a1 );
+        state_ = engaged_state;
+    }
+
+    template< typename A1, typename A2 >
+    void initialize( A1 const & a1, A2 const & a2 )
+    {
+        assert( ! has_object() );
+        contained.construct_value( a1, a2 );
+        state_ = engaged_state;
+    }
+
+    template< typename A1, typename A2, typename A3 >
+    void initialize( A1 const & a1, A2 const & a2, A3 const & a3 )
+    {
+        assert( ! has_object() );
+        contained.construct_value( a1, a2, a3 );
+        state_ = engaged_state;
+    }
+
+    template< typename V >
+    void assign_value( V const & v )
+    {
+        if ( has_object() ) { value() = v; state_ = engaged_state; }
+        else                initialize( v );
+    }
+#endif
+
+    void recycle()
+    {
+        if ( has_value() )
+        {
+            state_ = recycled_state;
+        }
+    }
+
+    void reset()
+    {
+        if ( has_object() )
+        {
+            contained.destruct_value();
+            state_ = empty_state;
+        }
+    }
+
+private:
+    enum { empty_state, engaged_state, recycled_state };
+
+    unsigned char state_;
+    storage_t< T > contained;
+};
+
+// copy, move and destruction semantics for the engaged value;
+// with C++11 and later, a trivially copyable T yields a trivially copyable optional:
+
+#if optional_CPP11_OR_GREATER
+
+template< typename T >
+struct is_trivially_copyable_value : std::integral_constant< bool,
+    std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value > {};
+
+template< typename T, bool = is_trivially_copyable_value<T>::value >
+class optional_storage;
+
+template< typename T >
+class optional_storage< T, true > : public optional_storage_base<T>
+{
+public:
+    using optional_storage_base<T>::optional_storage_base;
+};
+
+template< typename T >
+class optional_storage< T, false > : public optional_storage_base<T>
+#else
+template< typename T >
+class optional_storage : public optional_storage_base<T>
+#endif
+{
+public:
+    optional_storage() {}
+
+#if optional_CPP11_OR_GREATER
+    using optional_storage_base<T>::optional_storage_base;
+#endif
+
+    optional_storage( optional_storage const & other )
+    : optional_storage_base<T>()
+    {
+        if ( other.has_value() )
+            this->initialize( other.value() );
+    }
+
+#if optional_CPP11_OR_GREATER
+    optional_storage( optional_storage && other ) noexcept( std::is_nothrow_move_constructible<T>::value )
+    : optional_storage_base<T>()
+    {
+        if ( other.has_value() )
+            this->initialize( std::move( other.value() ) );
+    }
+#endif
+
+    ~optional_storage()
+    {
+        this->reset();
+    }
+
+    optional_storage & operator=( optional_storage const & other )
+    {
+        if ( other.has_value() ) this->assign_value( other.value() );
+        else                     this->reset();
+        return *this;
+    }
+
+#if optional_CPP11_OR_GREATER
+    optional_storage & operator=( optional_storage && other ) noexcept( std::is_nothrow_move_assignable<T>::value && std::is_nothrow_move_constructible<T>::value )
+    {
+        if ( other.has_value() ) this->assign_value( std::move( other.value() ) );
+        else                     this->reset();
+        return *this;
+    }
+#endif
+};
+
+#if optional_CPP11_OR_GREATER
+
+// type of the result of invoking an F with arguments of types Args, without cv-qualifiers and reference;
+// an alias, so that an F that cannot be invoked removes the overload instead of causing an error:
+
+template< typename F, typename... Args >
+using invoke_result_t = typename std::decay< decltype( std::declval<F>()( std::declval<Args>()... ) ) >::type;
+
+#endif
+
+} // namespace detail
+
+// Simplistic optional: requires T to be copyable.
+// The value lives in uninitialized aligned storage and is only constructed
+// when the optional becomes engaged.
+
+template< typename T >
+class optional
+{
+private:
+    typedef void (optional::*safe_bool)() const;
+
+public:
+    typedef T value_type;
+
+    optional_constexpr optional()
+    {}
+
+    optional_constexpr optional( nullopt_t )
+    {}
+
+    template< class U >
+    optional( optional<U> const & other )
+    {
+        if ( other.has_value() )
+            contained.initialize( *other );
+    }
+
+#if optional_CPP11_OR_GREATER
+    constexpr optional( T const & arg )
+    : contained( in_place, arg )
+    {}
+
+    constexpr optional( T && arg )
+    : contained( in_place, std::move( arg ) )
+    {}
+
+    template< class U >
+    optional( optional<U> && other )
+    {
+        if ( other.has_value() )
+            contained.initialize( std::move( *other ) );
+    }
+
+    template< typename... Args >
+    constexpr explicit optional( in_place_t, Args&&... args )
+    : contained( in_place, std::forward<Args>( args )... )
+    {}
+#else
+    optional( T const & arg )
+    {
+        contained.initialize( arg );
+    }
+
+    explicit optional( in_place_t )
+    {
+        contained.initialize();
+    }
+
+    template< typename A1 >
+    optional( in_place_t, A1 const & a1 )
+    {
+        contained.initialize( a1 );
+    }
+
+    template< typename A1, typename A2 >
+    optional( in_place_t, A1 const & a1, A2 const & a2 )
+    {
+        contained.initialize( a1, a2 );
+    }
+
+    template< typename A1, typename A2, typename A3 >
+    optional( in_place_t, A1 const & a1, A2 const & a2, A3 const & a3 )
+    {
+        contained.initialize( a1, a2, a3 );
+    }
+#endif
+
+    // copy and move construction and assignment, and destruction are provided
+    // by contained, trivially for a trivially copyable T (C++11).
+
+    optional & operator=( nullopt_t )
+    {
+        reset();
+        return *this;
+    }
+
+    template< class U >
+    optional & operator=( optional<U> const & other )
+    {
+        if ( other.has_value() ) contained.assign_value( *other );
+        else                     reset();
+        return *this;
+    }
+
+#if optional_CPP11_OR_GREATER
+    template< class U >
+    optional & operator=( optional<U> && other )
+    {
+        if ( other.has_value() ) contained.assign_value( std::move( *other ) );
+        else                     reset();
+        return *this;
+    }
+#endif
+
+    void swap( optional & rhs )
+    {
+        using std::swap;
+#if optional_CPP11_OR_GREATER
+        if      ( has_value() == true  && rhs.has_value() == true  ) { swap( **this, *rhs ); }
+        else if ( has_value() == false && rhs.has_value() == true  ) { contained.assign_value( std::move( *rhs ) ); rhs.reset(); }
+        else if ( has_value() == true  && rhs.has_value() == false ) { rhs.contained.assign_value( std::move( **this ) ); reset(); }
+#else
+        if      ( has_value() == true  && rhs.has_value() == true  ) { swap( **this, *rhs ); }
+        else if ( has_value() == false && rhs.has_value() == true  ) { contained.assign_value( *rhs ); rhs.reset(); }
+        else if ( has_value() == true  && rhs.has_value() == false ) { rhs.contained.assign_value( **this ); reset(); }
+#endif
+    }
+
+    // observers
+
+    optional_constexpr value_type const * operator->() const
+    {
+        return assert( has_value() ),
+            &contained.value();
+    }
+
+    optional_constexpr14 value_type * operator->()
+    {
+        return assert( has_value() ),
+            &contained.value();
+    }
+
+#if optional_CPP11_OR_GREATER
+    constexpr value_type const & operator*() const &
+    {
+        return assert( has_value() ),
+            contained.value();
+    }
+
+    optional_constexpr14 value_type & operator*() &
+    {
+        return assert( has_value() ),
+            contained.value();
+    }
+
+    constexpr value_type const && operator*() const &&
+    {
+        return assert( has_value() ),
+            std::move( contained.value() );
+    }
+
+    optional_constexpr14 value_type && operator*() &&
+    {
+        return assert( has_value() ),
+            std::move( contained.value() );
+    }
+#else
+    value_type const & operator*() const
+    {
+        return assert( has_value() ),
+            contained.value();
+    }
+
+    value_type & operator*()
+    {
+        return assert( has_value() ),
+            contained.value();
+    }
+#endif
+
+#if optional_CPP11_OR_GREATER
+    constexpr explicit operator bool() const
+    {
+        return has_value();
+    }
+#else
+    operator safe_bool() const
+    {
+        return has_value() ? &optional::this_type_does_not_support_comparisons : 0;
+    }
+#endif
+
+    optional_constexpr bool has_value() const
+    {
+        return contained.has_value();
+    }
+
+#if optional_CPP11_OR_GREATER
+    optional_constexpr14 value_type const & value() const &
+    {
+        return check_access(), contained.value();
+    }
+
+    optional_constexpr14 value_type & value() &
+    {
+        return check_access(), contained.value();
+    }
+
+    optional_constexpr14 value_type const && value() const &&
+    {
+        return check_access(), std::move( contained.value() );
+    }
+
+    optional_constexpr14 value_type && value() &&
+    {
+        return check_access(), std::move( contained.value() );
+    }
+
+    template< class U >
+    constexpr value_type value_or( U && v ) const &
+    {
+        return has_value() ? contained.value() : static_cast<value_type>( std::forward<U>( v ) );
+    }
+
+    template< class U >
+    optional_constexpr14 value_type value_or( U && v ) &&
+    {
+        return has_value() ? std::move( contained.value() ) : static_cast<value_type>( std::forward<U>( v ) );
+    }
+#else
+    value_type const & value() const
+    {
+        return check_access(), contained.value();
+    }
+
+    value_type & value()
+    {
+        return check_access(), contained.value();
+    }
+
+    template< class U >
+    value_type value_or( U const & v ) const
+    {
+        return has_value() ? contained.value() : static_cast<value_type>( v );
+    }
+#endif
+
+    // value or fallback, where the fallback is only created when the optional is empty:
+
+#if optional_CPP11_OR_GREATER
+    template< class F >
+    value_type value_or_else( F && f ) const &
+    {
+        return has_value() ? contained.value() : static_cast<value_type>( std::forward<F>( f )() );
+    }
+
+    template< class F >
+    value_type value_or_else( F && f ) &&
+    {
+        return has_value() ? std::move( contained.value() ) : static_cast<value_type>( std::forward<F>( f )() );
+    }
+#else
+    template< class F >
+    value_type value_or_else( F f ) const
+    {
+        return has_value() ? contained.value() : static_cast<value_type>( f() );
+    }
+#endif
+
+#if optional_CPP11_OR_GREATER
+
+    // monadic operations:
+
+    // f( value ) if engaged, an empty optional of f's result type otherwise:
+
+    template< class F, class R = detail::invoke_result_t< F, value_type & > >
+    R and_then( F && f ) &
+    {
+        return has_value() ? std::forward<F>( f )( contained.value() ) : R();
+    }
+
+    template< class F, class R = detail::invoke_result_t< F, value_type const & > >
+    R and_then( F && f ) const &
+    {
+        return has_value() ? std::forward<F>( f )( contained.value() ) : R();
+    }
+
+    template< class F, class R = detail::invoke_result_t< F, value_type && > >
+    R and_then( F && f ) &&
+    {
+        return has_value() ? std::forward<F>( f )( std::move( contained.value() ) ) : R();
+    }
+
+    // optional holding f( value ) if engaged, an empty optional otherwise:
+
+    template< class F, class U = detail::invoke_result_t< F, value_type & > >
+    optional<U> transform( F && f ) &
+    {
+        return has_value() ? optional<U>( std::forward<F>( f )( contained.value() ) ) : optional<U>();
+    }
+
+    template< class F, class U = detail::invoke_result_t< F, value_type const & > >
+    optional<U> transform( F && f ) const &
+    {
+        return has_value() ? optional<U>( std::forward<F>( f )( contained.value() ) ) : optional<U>();
+    }
+
+    template< class F, class U = detail::invoke_result_t< F, value_type && > >
+    optional<U> transform( F && f ) &&
+    {
+        return has_value() ? optional<U>( std::forward<F>( f )( std::move( contained.value() ) ) ) : optional<U>();
+    }
+
+    // this optional if engaged, the optional that f() yields otherwise:
+
+    template< class F >
+    optional or_else( F && f ) const &
+    {
+        return has_value() ? *this : static_cast<optional>( std::forward<F>( f )() );
+    }
+
+    template< class F >
+    optional or_else( F && f ) &&
+    {
+        return has_value() ? std::move( *this ) : static_cast<optional>( std::forward<F>( f )() );
+    }
+
+#endif // optional_CPP11_OR_GREATER
+
+    // modifiers
+
+#if optional_CPP11_OR_GREATER
+    template< typename... Args >
+    T & emplace( Args&&... args )
+    {
+        reset();
+        contained.initialize( std::forward<Args>( args )... );
+        return contained.value();
+    }
+#else
+    T & emplace()
+    {
+        reset();
+        contained.initialize();
+        return contained.value();
+    }
+
+    template< typename A1 >
+    T & emplace( A1 const & a1 )
+    {
+        reset();
+        contained.initialize( a1 );
+        return contained.value();
+    }
+
+    template< typename A1, typename A2 >
+    T & emplace( A1 const & a1, A2 const & a2 )
+    {
+        reset();
+        contained.initialize( a1, a2 );
+        return contained.value();
+    }
+
+    template< typename A1, typename A2, typename A3 >
+    T & emplace( A1 const & a1, A2 const & a2, A3 const & a3 )
+    {
+        reset();
+        contained.initialize( a1, a2, a3 );
+        return contained.value();
+    }
+#endif
+
+    // destroy the value, also a recycled one, releasing the resources it holds:
+
+    void reset()
+    {
+        contained.reset();
+    }
+
+    // disengage, but keep the value alive so that its resources can be reused:
+
+    void recycle()
+    {
+        contained.recycle();
+    }
+
+    // engage via T's assignment to a recycled value, or via construction otherwise:
+
+#if optional_CPP11_OR_GREATER
+    template< typename U >
+    T & assign_reuse( U && v )
+    {
+        contained.assign_value( std::forward<U>( v ) );
+        return contained.value();
+    }
+#else
+    template< typename U >
+    T & assign_reuse( U const & v )
+    {
+        contained.assign_value( v );
+        return contained.value();
+    }
+#endif
+
+private:
+    void this_type_does_not_support_comparisons() const {}
+
+    optional_constexpr14 void check_access() const
+    {
+#if optional_CONFIG_NO_EXCEPTIONS
+        assert( has_value() );
+#else
+        if ( ! has_value() )
+            throw bad_optional_access();
+#endif
+    }
+
+private:
+    detail::optional_storage< value_type > contained;
+};
+
+// Optional reference: refers to a T via a pointer that is null when empty,
+// so that sizeof( optional<T&> ) == sizeof( T* ). Assignment rebinds the reference.
+
+template< typename T >
+class optional< T & >
+{
+private:
+    typedef void (optional::*safe_bool)() const;
+
+public:
+    typedef T & value_type;
+
+    optional_constexpr optional()
+    : ptr_( 0 )
+    {}
+
+    optional_constexpr optional( nullopt_t )
+    : ptr_( 0 )
+    {}
+
+    optional_constexpr optional( T & ref )
+    : ptr_( &ref )
+    {}
+
+    template< class U >
+    optional_constexpr optional( optional<U &> const & other )
+    : ptr_( other.has_value() ? &*other : 0 )
+    {}
+
+#if optional_CPP11_OR_GREATER
+    // prevent referring to a temporary:
+
+    optional( T && ) = delete;
+#endif
+
+    optional & operator=( nullopt_t )
+    {
+        reset();
+        return *this;
+    }
+
+    void swap( optional & rhs )
+    {
+        T * tmp = ptr_; ptr_ = rhs.ptr_; rhs.ptr_ = tmp;
+    }
+
+    // observers
+
+    optional_constexpr T * operator->() const
+    {
+        return assert( has_value() ),
+            ptr_;
+    }
+
+    optional_constexpr T & operator*() const
+    {
+        return assert( has_value() ),
+            *ptr_;
+    }
+
+#if optional_CPP11_OR_GREATER
+    constexpr explicit operator bool() const
+    {
+        return has_value();
+    }
+#else
+    operator safe_bool() const
+    {
+        return has_value() ? &optional::this_type_does_not_support_comparisons : 0;
+    }
+#endif
+
+    optional_constexpr bool has_value() const
+    {
+        return ptr_ != 0;
+    }
+
+    optional_constexpr14 T & value() const
+    {
+        return check_access(), *ptr_;
+    }
+
+    // a copy of the referred-to value or of the default:
+
+    template< class U >
+    optional_constexpr typename detail::remove_const<T>::type value_or( U const & v ) const
+    {
+        return has_value() ? *ptr_ : static_cast<typename detail::remove_const<T>::type>( v );
+    }
+
+    // modifiers
+
+    T & emplace( T & ref )
+    {
+        ptr_ = &ref;
+        return ref;
+    }
+
+    void reset()
+    {
+        ptr_ = 0;
+    }
+
+private:
+    void this_type_does_not_support_comparisons() const {}
+
+    optional_constexpr14 void check_access() const
+    {
+#if optional_CONFIG_NO_EXCEPTIONS
+        assert( has_value() );
+#else
+        if ( ! has_value() )
+            throw bad_optional_access();
+#endif
+    }
+
+private:
+    T * ptr_;
+};
+
+// Relational operators
+
+template< typename T, typename U >
+inline optional_constexpr bool operator==( optional<T> const & x, optional<U> const & y )
+{
+    return bool(x) != bool(y) ? false : bool(x) == false ? true : *x == *y;
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator!=( optional<T> const & x, optional<U> const & y )
+{
+    return !(x == y);
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator<( optional<T> const & x, optional<U> const & y )
+{
+    return (!y) ? false : (!x) ? true : *x < *y;
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator>( optional<T> const & x, optional<U> const & y )
+{
+    return (y < x);
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator<=( optional<T> const & x, optional<U> const & y )
+{
+    return !(y < x);
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator>=( optional<T> const & x, optional<U> const & y )
+{
+    return !(x < y);
+}
+
+// Comparison with nullopt
+
+template< typename T >
+inline optional_constexpr bool operator==( optional<T> const & x, nullopt_t )
+{
+    return (!x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator==( nullopt_t, optional<T> const & x )
+{
+    return (!x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator!=( optional<T> const & x, nullopt_t )
+{
+    return bool(x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator!=( nullopt_t, optional<T> const & x )
+{
+    return bool(x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator<( optional<T> const &, nullopt_t )
+{
+    return false;
+}
+
+template< typename T >
+inline optional_constexpr bool operator<( nullopt_t, optional<T> const & x )
+{
+    return bool(x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator<=( optional<T> const & x, nullopt_t )
+{
+    return (!x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator<=( nullopt_t, optional<T> const & )
+{
+    return true;
+}
+
+template< typename T >
+inline optional_constexpr bool operator>( optional<T> const & x, nullopt_t )
+{
+    return bool(x);
+}
+
+template< typename T >
+inline optional_constexpr bool operator>( nullopt_t, optional<T> const & )
+{
+    return false;
+}
+
+template< typename T >
+inline optional_constexpr bool operator>=( optional<T> const &, nullopt_t )
+{
+    return true;
+}
+
+template< typename T >
+inline optional_constexpr bool operator>=( nullopt_t, optional<T> const & x )
+{
+    return (!x);
+}
+
+// Comparison with T
+
+template< typename T, typename U >
+inline optional_constexpr bool operator==( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x == v : false;
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator==( U const & v, optional<T> const & x )
+{
+    return bool(x) ? v == *x : false;
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator!=( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x != v : true;
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator!=( U const & v, optional<T> const & x )
+{
+    return bool(x) ? v != *x : true;
+}
+
+template< typename T, typename U >
+inline optional_constexpr bool operator<( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x < v : true;
+}
 
-#define optional_USES_STD_OPTIONAL  ( (optional_CONFIG_SELECT_OPTIONAL == optional_OPTIONAL_STD) || ((optional_CONFIG_SELECT_OPTIONAL == optional_OPTIONAL_DEFAULT) && optional_HAVE_STD_OPTIONAL) )
+template< typename T, typename U >
+inline optional_constexpr bool operator<( U const & v, optional<T> const & x )
+{
+    return bool(x) ? v < *x : false;
+}
 
-//
-// Using std::optional:
-//
+template< typename T, typename U >
+inline optional_constexpr bool operator<=( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x <= v : true;
+}
 
-#if optional_USES_STD_OPTIONAL
+template< typename T, typename U >
+inline optional_constexpr bool operator<=( U const & v, optional<T> const & x )
+{
+    return bool(x) ? v <= *x : false;
+}
 
-#include <optional>
-#include <utility>
+template< typename T, typename U >
+inline optional_constexpr bool operator>( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x > v : false;
+}
 
-namespace nonstd {
+template< typename T, typename U >
+inline optional_constexpr bool operator>( U const & v, optional<T> const & x )
+{
+    return bool(x) ? v > *x : true;
+}
 
-    using std::in_place;
-    using std::in_place_type;
-    using std::in_place_index;
-    using std::in_place_t;
-    using std::in_place_type_t;
-    using std::in_place_index_t;
+template< typename T, typename U >
+inline optional_constexpr bool operator>=( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x >= v : false;
+}
 
-    using std::optional;
-    using std::bad_optional_access;
-    using std::hash;
+template< typename T, typename U >
+inline optional_constexpr bool operator>=( U const & v, optional<T> const & x )
+{
+    return bool(x) ? v >= *x : true;
+}
 
-    using std::nullopt;
-    using std::nullopt_t;
+#if optional_HAVE_THREE_WAY_COMPARISON
 
-    using std::operator==;
-    using std::operator!=;
-    using std::operator<;
-    using std::operator<=;
-    using std::operator>;
-    using std::operator>=;
-    using std::make_optional;
-    using std::swap;
+// Three-way comparison (C++20), yielding the comparison category of the values;
+// a single comparison of the values, also via rewritten expressions:
+
+namespace detail {
+
+template< typename T > struct is_optional : std::false_type {};
+template< typename T > struct is_optional< optional<T> > : std::true_type {};
+
+} // namespace detail
+
+template< typename T, std::three_way_comparable_with<T> U >
+constexpr std::compare_three_way_result_t<T, U> operator<=>( optional<T> const & x, optional<U> const & y )
+{
+    return x && y ? *x <=> *y : bool(x) <=> bool(y);
 }
 
-#else // optional_USES_STD_OPTIONAL
+template< typename T >
+constexpr std::strong_ordering operator<=>( optional<T> const & x, nullopt_t ) noexcept
+{
+    return bool(x) <=> false;
+}
 
-#include <cassert>
+template< typename T, typename U >
+    requires ( ! detail::is_optional<U>::value ) && std::three_way_comparable_with<T, U>
+constexpr std::compare_three_way_result_t<T, U> operator<=>( optional<T> const & x, U const & v )
+{
+    return bool(x) ? *x <=> v : std::strong_ordering::less;
+}
 
-#if ! optional_CONFIG_NO_EXCEPTIONS
-# include <stdexcept>
-#endif
+#endif // optional_HAVE_THREE_WAY_COMPARISON
 
-namespace nonstd { namespace optional_bare {
+// Specialized algorithms
 
-// type for nullopt
+template< typename T >
+void swap( optional<T> & x, optional<T> & y )
+{
+    x.swap( y );
+}
 
-struct nullopt_t
+// Convenience functions to create an optional.
+
+#if optional_CPP11_OR_GREATER
+
+template< typename T >
+inline constexpr optional< typename std::decay<T>::type > make_optional( T && v )
 {
-    struct init{};
-    nullopt_t( init ) {}
-};
+    return optional< typename std::decay<T>::type >( std::forward<T>( v ) );
+}
 
-// extra parenthesis to prevent the most vexing parse:
+template< typename T, typename... Args >
+inline constexpr optional<T> make_optional( Args&&... args )
+{
+    return optional<T>( in_place, std::forward<Args>( args )... );
+}
 
-const nullopt_t nullopt(( nullopt_t::init() ));
+#else
 
-// optional access error.
+template< typename T >
+inline optional<T> make_optional( T const & v )
+{
+    return optional<T>( v );
+}
 
-#if ! optional_CONFIG_NO_EXCEPTIONS
+template< typename T >
+inline optional<T> make_optional()
+{
+    return optional<T>( in_place );
+}
 
-class bad_optional_access : public std::logic_error
+// Note: make_optional<T>( a1 ) would be ambiguous with make_optional( T const & ),
+// use optional<T>( in_place, a1 ) for in-place construction from a single argument.
+
+template< typename T, typename A1, typename A2 >
+inline optional<T> make_optional( A1 const & a1, A2 const & a2 )
 {
-public:
-  explicit bad_optional_access()
-  : logic_error( "bad optional access" ) {}
+    return optional<T>( in_place, a1, a2 );
+}
+
+template< typename T, typename A1, typename A2, typename A3 >
+inline optional<T> make_optional( A1 const & a1, A2 const & a2, A3 const & a3 )
+{
+    return optional<T>( in_place, a1, a2, a3 );
+}
+
+#endif // optional_CPP11_OR_GREATER
+
+} // namespace optional-bare
+
+using namespace optional_bare;
+
+} // namespace nonstd
+
+#if optional_CPP11_OR_GREATER
+
+#include <functional>
+
+namespace nonstd { namespace optional_bare { namespace detail {
+
+// hash of an optional, enabled if std::hash of its value type is: the hash of
+// the value combined with the engaged state, so that the hash of an empty
+// optional differs from that of an engaged optional of a small integer even
+// with an identity std::hash; also for optional<T&>:
+
+template< typename T, typename U = typename std::remove_cv< typename std::remove_reference<T>::type >::type,
+    bool = std::is_default_constructible< std::hash<U> >::value >
+struct optional_hash
+{
+    std::size_t operator()( optional<T> const & v ) const
+    {
+        std::size_t const seed = bool( v );
+        std::size_t const h = bool( v ) ? std::hash<U>()( *v ) : 0;
+
+        return seed ^ ( h + static_cast<std::size_t>( 0x9e3779b97f4a7c15ull ) + ( seed << 6 ) + ( seed >> 2 ) );
+    }
 };
 
-#endif // optional_CONFIG_NO_EXCEPTIONS
+// disabled hash, as std::hash of a type without a hash:
+
+template< typename T, typename U >
+struct optional_hash< T, U, false >
+{
+    optional_hash() = delete;
+    optional_hash( optional_hash const & ) = delete;
+    optional_hash & operator=( optional_hash const & ) = delete;
+};
 
-// Simplistic optional: requires T to be default constructible, copyable.
+}}} // namespace nonstd::optional_bare::detail
 
-template< typename T >
-class optional
+namespace std {
+
+template< class T >
+struct hash< nonstd::optional_bare::optional<T> > : nonstd::optional_bare::detail::optional_hash<T> {};
+
+} // namespace std
+
+#endif // optional_CPP11_OR_GREATER
+
+#endif // optional_USES_STD_OPTIONAL
+
+//
+// compact_optional, available with std::optional and with nonstd::optional:
+//
+
+#include <cassert>
+
+namespace nonstd { namespace optional_bare {
+
+// Policy for compact_optional that reserves a single value of an integral type,
+// such as INT_MIN, -1 or the maximum index, to represent the empty state.
+//
+// A policy provides:
+// - static T empty_value(): the value that is stored when the optional is empty,
+// - static bool is_empty_value( T const & v ): true if v represents the empty state.
+
+template< typename T, T Sentinel >
+struct sentinel_policy
+{
+    static optional_constexpr T empty_value()
+    {
+        return Sentinel;
+    }
+
+    static optional_constexpr bool is_empty_value( T const & v )
+    {
+        return v == Sentinel;
+    }
+};
+
+// Optional without engaged flag: the empty state is encoded in the value itself,
+// so that sizeof( compact_optional<T, Policy> ) == sizeof( T ).
+// Note: storing the reserved value makes the optional empty.
+
+template< typename T, typename Policy >
+class compact_optional
 {
 private:
-    typedef void (optional::*safe_bool)() const;
+    typedef void (compact_optional::*safe_bool)() const;
 
 public:
     typedef T value_type;
+    typedef Policy policy_type;
 
-    optional()
-    : has_value_( false )
+    optional_constexpr compact_optional()
+    : value_( Policy::empty_value() )
     {}
 
-    optional( nullopt_t )
-    : has_value_( false )
+    optional_constexpr compact_optional( nullopt_t )
+    : value_( Policy::empty_value() )
     {}
 
-    optional( T const & arg )
-    : has_value_( true )
-    , value_    ( arg  )
+    optional_constexpr compact_optional( T const & arg )
+    : value_( arg )
     {}
 
-    template< class U >
-    optional( optional<U> const & other )
-    : has_value_( other.has_value() )
-    {
-        if ( other.has_value() )
-            value_ = other.value();
-    }
-
-    optional & operator=( nullopt_t )
+    compact_optional & operator=( nullopt_t )
     {
         reset();
         return *this;
     }
 
-    template< class U >
-    optional & operator=( optional<U> const & other )
-    {
-        has_value_ = other.has_value();
-        if ( other.has_value() )
-            value_ = other.value();
-        return *this;
-    }
-
-    void swap( optional & rhs )
+    void swap( compact_optional & rhs )
     {
         using std::swap;
-        if      ( has_value() == true  && rhs.has_value() == true  ) { swap( **this, *rhs ); }
-        else if ( has_value() == false && rhs.has_value() == true  ) { initialize( *rhs ); rhs.reset(); }
-        else if ( has_value() == true  && rhs.has_value() == false ) { rhs.initialize( **this ); reset(); }
+        swap( value_, rhs.value_ );
     }
 
     // observers
 
-    value_type const * operator->() const
+    optional_constexpr value_type const * operator->() const
     {
         return assert( has_value() ),
             &value_;
     }
 
-    value_type * operator->()
+    optional_constexpr14 value_type * operator->()
     {
         return assert( has_value() ),
             &value_;
     }
 
-    value_type const & operator*() const
+    optional_constexpr value_type const & operator*() const
     {
         return assert( has_value() ),
             value_;
     }
 
-    value_type & operator*()
+    optional_constexpr14 value_type & operator*()
     {
         return assert( has_value() ),
             value_;
     }
 
 #if optional_CPP11_OR_GREATER
-    explicit operator bool() const
+    constexpr explicit operator bool() const
     {
         return has_value();
     }
 #else
     operator safe_bool() const
     {
-        return has_value() ? &optional::this_type_does_not_support_comparisons : 0;
+        return has_value() ? &compact_optional::this_type_does_not_support_comparisons : 0;
     }
 #endif
 
-    bool has_value() const
+    optional_constexpr bool has_value() const
     {
-        return has_value_;
+        return ! Policy::is_empty_value( value_ );
     }
 
-    value_type const & value() const
+    optional_constexpr14 value_type const & value() const
     {
-#if optional_CONFIG_NO_EXCEPTIONS
-        assert( has_value() );
-#else
-        if ( ! has_value() )
-            throw bad_optional_access();
-#endif
-        return value_;
+        return check_access(), value_;
     }
 
-    value_type & value()
+    optional_constexpr14 value_type & value()
     {
-#if optional_CONFIG_NO_EXCEPTIONS
-        assert( has_value() );
-#else
-        if ( ! has_value() )
-            throw bad_optional_access();
-#endif
-        return value_;
+        return check_access(), value_;
     }
 
     template< class U >
-    value_type value_or( U const & v ) const
+    optional_constexpr value_type value_or( U const & v ) const
     {
-        return has_value() ? value() : static_cast<value_type>( v );
+        return has_value() ? value_ : static_cast<value_type>( v );
     }
 
     // modifiers
 
     void reset()
     {
-        has_value_ = false;
+        value_ = Policy::empty_value();
     }
 
 private:
     void this_type_does_not_support_comparisons() const {}
 
-    template< typename V >
-    void initialize( V const & value )
+    optional_constexpr14 void check_access() const
     {
-        assert( ! has_value()  );
-        value_ = value;
-        has_value_ = true;
+#if optional_CONFIG_NO_EXCEPTIONS
+        assert( has_value() );
+#else
+        if ( ! has_value() )
+            throw bad_optional_access();
+#endif
     }
 
 private:
-    bool has_value_;
     value_type value_;
 };
 
 // Relational operators
 
-template< typename T, typename U >
-inline bool operator==( optional<T> const & x, optional<U> const & y )
+template< typename T, typename P, typename U, typename Q >
+inline optional_constexpr bool operator==( compact_optional<T, P> const & x, compact_optional<U, Q> const & y )
 {
     return bool(x) != bool(y) ? false : bool(x) == false ? true : *x == *y;
 }
 
-template< typename T, typename U >
-inline bool operator!=( optional<T> const & x, optional<U> const & y )
+template< typename T, typename P, typename U, typename Q >
+inline optional_constexpr bool operator!=( compact_optional<T, P> const & x, compact_optional<U, Q> const & y )
 {
     return !(x == y);
 }
 
-template< typename T, typename U >
-inline bool operator<( optional<T> const & x, optional<U> const & y )
+template< typename T, typename P, typename U, typename Q >
+inline optional_constexpr bool operator<( compact_optional<T, P> const & x, compact_optional<U, Q> const & y )
 {
     return (!y) ? false : (!x) ? true : *x < *y;
 }
 
-template< typename T, typename U >
-inline bool operator>( optional<T> const & x, optional<U> const & y )
+template< typename T, typename P, typename U, typename Q >
+inline optional_constexpr bool operator>( compact_optional<T, P> const & x, compact_optional<U, Q> const & y )
 {
     return (y < x);
 }
 
-template< typename T, typename U >
-inline bool operator<=( optional<T> const & x, optional<U> const & y )
+template< typename T, typename P, typename U, typename Q >
+inline optional_constexpr bool operator<=( compact_optional<T, P> const & x, compact_optional<U, Q> const & y )
 {
     return !(y < x);
 }
 
-template< typename T, typename U >
-inline bool operator>=( optional<T> const & x, optional<U> const & y )
+template< typename T, typename P, typename U, typename Q >
+inline optional_constexpr bool operator>=( compact_optional<T, P> const & x, compact_optional<U, Q> const & y )
 {
     return !(x < y);
 }
 
 // Comparison with nullopt
 
-template< typename T >
-inline bool operator==( optional<T> const & x, nullopt_t )
+template< typename T, typename P >
+inline optional_constexpr bool operator==( compact_optional<T, P> const & x, nullopt_t )
 {
     return (!x);
 }
 
-template< typename T >
-inline bool operator==( nullopt_t, optional<T> const & x )
+template< typename T, typename P >
+inline optional_constexpr bool operator==( nullopt_t, compact_optional<T, P> const & x )
 {
     return (!x);
 }
 
-template< typename T >
-inline bool operator!=( optional<T> const & x, nullopt_t )
+template< typename T, typename P >
+inline optional_constexpr bool operator!=( compact_optional<T, P> const & x, nullopt_t )
 {
     return bool(x);
 }
 
-template< typename T >
-inline bool operator!=( nullopt_t, optional<T> const & x )
+template< typename T, typename P >
+inline optional_constexpr bool operator!=( nullopt_t, compact_optional<T, P> const & x )
 {
     return bool(x);
 }
 
-template< typename T >
-inline bool operator<( optional<T> const &, nullopt_t )
+template< typename T, typename P >
+inline optional_constexpr bool operator<( compact_optional<T, P> const &, nullopt_t )
 {
     return false;
 }
 
-template< typename T >
-inline bool operator<( nullopt_t, optional<T> const & x )
+template< typename T, typename P >
+inline optional_constexpr bool operator<( nullopt_t, compact_optional<T, P> const & x )
 {
     return bool(x);
 }
 
-template< typename T >
-inline bool operator<=( optional<T> const & x, nullopt_t )
+template< typename T, typename P >
+inline optional_constexpr bool operator<=( compact_optional<T, P> const & x, nullopt_t )
 {
     return (!x);
 }
 
-template< typename T >
-inline bool operator<=( nullopt_t, optional<T> const & )
+template< typename T, typename P >
+inline optional_constexpr bool operator<=( nullopt_t, compact_optional<T, P> const & )
 {
     return true;
 }
 
-template< typename T >
-inline bool operator>( optional<T> const & x, nullopt_t )
+template< typename T, typename P >
+inline optional_constexpr bool operator>( compact_optional<T, P> const & x, nullopt_t )
 {
     return bool(x);
 }
 
-template< typename T >
-inline bool operator>( nullopt_t, optional<T> const & )
+template< typename T, typename P >
+inline optional_constexpr bool operator>( nullopt_t, compact_optional<T, P> const & )
 {
     return false;
 }
 
-template< typename T >
-inline bool operator>=( optional<T> const &, nullopt_t )
+template< typename T, typename P >
+inline optional_constexpr bool operator>=( compact_optional<T, P> const &, nullopt_t )
 {
     return true;
 }
 
-template< typename T >
-inline bool operator>=( nullopt_t, optional<T> const & x )
+template< typename T, typename P >
+inline optional_constexpr bool operator>=( nullopt_t, compact_optional<T, P> const & x )
 {
     return (!x);
 }
 
 // Comparison with T
 
-template< typename T, typename U >
-inline bool operator==( optional<T> const & x, U const & v )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator==( compact_optional<T, P> const & x, U const & v )
 {
     return bool(x) ? *x == v : false;
 }
 
-template< typename T, typename U >
-inline bool operator==( U const & v, optional<T> const & x )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator==( U const & v, compact_optional<T, P> const & x )
 {
     return bool(x) ? v == *x : false;
 }
 
-template< typename T, typename U >
-inline bool operator!=( optional<T> const & x, U const & v )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator!=( compact_optional<T, P> const & x, U const & v )
 {
     return bool(x) ? *x != v : true;
 }
 
-template< typename T, typename U >
-inline bool operator!=( U const & v, optional<T> const & x )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator!=( U const & v, compact_optional<T, P> const & x )
 {
     return bool(x) ? v != *x : true;
 }
 
-template< typename T, typename U >
-inline bool operator<( optional<T> const & x, U const & v )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator<( compact_optional<T, P> const & x, U const & v )
 {
     return bool(x) ? *x < v : true;
 }
 
-template< typename T, typename U >
-inline bool operator<( U const & v, optional<T> const & x )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator<( U const & v, compact_optional<T, P> const & x )
 {
     return bool(x) ? v < *x : false;
 }
 
-template< typename T, typename U >
-inline bool operator<=( optional<T> const & x, U const & v )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator<=( compact_optional<T, P> const & x, U const & v )
 {
     return bool(x) ? *x <= v : true;
 }
 
-template< typename T, typename U >
-inline bool operator<=( U const & v, optional<T> const & x )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator<=( U const & v, compact_optional<T, P> const & x )
 {
     return bool(x) ? v <= *x : false;
 }
 
-template< typename T, typename U >
-inline bool operator>( optional<T> const & x, U const & v )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator>( compact_optional<T, P> const & x, U const & v )
 {
     return bool(x) ? *x > v : false;
 }
 
-template< typename T, typename U >
-inline bool operator>( U const & v, optional<T> const & x )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator>( U const & v, compact_optional<T, P> const & x )
 {
     return bool(x) ? v > *x : true;
 }
 
-template< typename T, typename U >
-inline bool operator>=( optional<T> const & x, U const & v )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator>=( compact_optional<T, P> const & x, U const & v )
 {
     return bool(x) ? *x >= v : false;
 }
 
-template< typename T, typename U >
-inline bool operator>=( U const & v, optional<T> const & x )
+template< typename T, typename P, typename U >
+inline optional_constexpr bool operator>=( U const & v, compact_optional<T, P> const & x )
 {
     return bool(x) ? v >= *x : true;
 }
 
 // Specialized algorithms
 
-template< typename T >
-void swap( optional<T> & x, optional<T> & y )
+template< typename T, typename P >
+void swap( compact_optional<T, P> & x, compact_optional<T, P> & y )
 {
     x.swap( y );
 }
 
-// Convenience function to create an optional.
-
-template< typename T >
-inline optional<T> make_optional( T const & v )
-{
-    return optional<T>( v );
-}
-
 } // namespace optional-bare
 
 using namespace optional_bare;
 
 } // namespace nonstd
 
-#endif // optional_USES_STD_OPTIONAL
-
 #endif // NONSTD_OPTIONAL_BARE_HPP
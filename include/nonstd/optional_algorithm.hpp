@@ -0,0 +1,2445 @@
+//
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NONSTD_OPTIONAL_ALGORITHM_HPP
+#define NONSTD_OPTIONAL_ALGORITHM_HPP
+
+#include "nonstd/optional.hpp"
+#include "nonstd/optional_vector.hpp"
+
+// optional-algorithm configuration:
+
+// Disable the use of SSE2 and AVX2 intrinsics:
+
+#ifndef  optional_CONFIG_NO_SIMD
+# define optional_CONFIG_NO_SIMD  0
+#endif
+
+// Presence of SSE2, AVX2 and AVX-512, as selected by the compiler options:
+
+#ifndef optional_HAVE_SSE2
+# if ! optional_CONFIG_NO_SIMD && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#  define optional_HAVE_SSE2  1
+# else
+#  define optional_HAVE_SSE2  0
+# endif
+#endif
+
+#if ! optional_CONFIG_NO_SIMD && defined( __AVX2__ )
+# define optional_HAVE_AVX2  1
+#else
+# define optional_HAVE_AVX2  0
+#endif
+
+#if ! optional_CONFIG_NO_SIMD && defined( __AVX512F__ )
+# define optional_HAVE_AVX512  1
+#else
+# define optional_HAVE_AVX512  0
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#if optional_HAVE_AVX2
+# include <immintrin.h>
+#elif optional_HAVE_SSE2
+# include <emmintrin.h>
+#endif
+
+namespace nonstd { namespace optional_algorithm {
+
+// Algorithms over a sequence of optionals of an arithmetic type, that skip the
+// disengaged elements without a branch per element. The sequence is either:
+// - a range of optional<T>, specified by a pair of iterators, or
+// - a column of values with a validity bitmap of n bits, least significant bit
+//   first, as provided by optional_vector<T>.
+// With SSE2, AVX2 or AVX-512, the column algorithms for double and int are vectorized.
+
+namespace detail {
+
+// type to accumulate a sum of T in:
+
+template< typename T > struct sum_type { typedef T type; };
+
+template<> struct sum_type< float          > { typedef double type; };
+template<> struct sum_type< signed char    > { typedef long long type; };
+template<> struct sum_type< short          > { typedef long long type; };
+template<> struct sum_type< int            > { typedef long long type; };
+template<> struct sum_type< long           > { typedef long long type; };
+template<> struct sum_type< unsigned char  > { typedef unsigned long long type; };
+template<> struct sum_type< unsigned short > { typedef unsigned long long type; };
+template<> struct sum_type< unsigned int   > { typedef unsigned long long type; };
+template<> struct sum_type< unsigned long  > { typedef unsigned long long type; };
+
+// value type T of an iterator to optional<T>; without member type for other
+// types, so that an overload for iterators is removed for these:
+
+template< typename T >
+struct void_type { typedef void type; };
+
+template< typename InputIt, typename = void >
+struct optional_value_type {};
+
+template< typename T >
+struct optional_value_type< T *, typename void_type< typename T::value_type >::type >
+{
+    typedef typename T::value_type type;
+};
+
+template< typename InputIt >
+struct optional_value_type< InputIt, typename void_type< typename InputIt::value_type::value_type >::type >
+{
+    typedef typename InputIt::value_type::value_type type;
+};
+
+// identity elements of min and max:
+
+template< typename T >
+inline T min_identity()
+{
+    return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::max)();
+}
+
+template< typename T >
+inline T max_identity()
+{
+    return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+         : std::numeric_limits<T>::is_integer   ? (std::numeric_limits<T>::min)() : -(std::numeric_limits<T>::max)();
+}
+
+// engaged state of element i of a bitmap:
+
+inline bool test( unsigned char const * bitmap, std::size_t i )
+{
+    return 0 != ( ( static_cast<unsigned>( bitmap[ i / 8 ] ) >> ( i % 8 ) ) & 1u );
+}
+
+// value of an optional, or zero if it is empty:
+
+template< typename T >
+inline T value_or_zero( optional<T> const & x )
+{
+    return x.has_value() ? *x : T();
+}
+
+// number of bits set in a 64-bit word:
+
+inline std::size_t popcount( unsigned long long w )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast<std::size_t>( __builtin_popcountll( w ) );
+#else
+    w = w - ( ( w >> 1 ) & 0x5555555555555555ull );
+    w = ( w & 0x3333333333333333ull ) + ( ( w >> 2 ) & 0x3333333333333333ull );
+    w = ( w + ( w >> 4 ) ) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<std::size_t>( ( w * 0x0101010101010101ull ) >> 56 );
+#endif
+}
+
+// smallest and largest of the n lanes of a vector register, stored in r:
+
+template< typename T >
+T reduce_min( T const * r, int n, T m )
+{
+    for ( int k = 0; k < n; ++k )
+        m = r[k] < m ? r[k] : m;
+    return m;
+}
+
+template< typename T >
+T reduce_max( T const * r, int n, T m )
+{
+    for ( int k = 0; k < n; ++k )
+        m = m < r[k] ? r[k] : m;
+    return m;
+}
+
+// scalar column kernels for elements [first, n):
+
+template< typename T >
+typename sum_type<T>::type sum_scalar( T const * values, unsigned char const * bitmap, std::size_t first, std::size_t n )
+{
+    typedef typename sum_type<T>::type S;
+
+    S s = S();
+    for ( std::size_t i = first; i < n; ++i )
+    {
+        S const v = static_cast<S>( values[i] );
+        s += test( bitmap, i ) ? v : S();
+    }
+    return s;
+}
+
+template< typename T >
+T min_scalar( T const * values, unsigned char const * bitmap, std::size_t first, std::size_t n, T m )
+{
+    for ( std::size_t i = first; i < n; ++i )
+    {
+        T const v = values[i];
+        m = ( test( bitmap, i ) & ( v < m ) ) ? v : m;
+    }
+    return m;
+}
+
+template< typename T >
+T max_scalar( T const * values, unsigned char const * bitmap, std::size_t first, std::size_t n, T m )
+{
+    for ( std::size_t i = first; i < n; ++i )
+    {
+        T const v = values[i];
+        m = ( test( bitmap, i ) & ( m < v ) ) ? v : m;
+    }
+    return m;
+}
+
+// column kernels, generic:
+
+template< typename T >
+typename sum_type<T>::type sum_column( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    return sum_scalar( values, bitmap, 0, n );
+}
+
+template< typename T >
+T min_column( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    return min_scalar( values, bitmap, 0, n, min_identity<T>() );
+}
+
+template< typename T >
+T max_column( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    return max_scalar( values, bitmap, 0, n, max_identity<T>() );
+}
+
+#if optional_HAVE_AVX2
+
+// column kernels for double and int, eight elements per bitmap byte:
+
+inline __m256d mask_pd( unsigned char byte, __m256i select )
+{
+    __m256i const b = _mm256_set1_epi64x( byte );
+    return _mm256_castsi256_pd( _mm256_cmpeq_epi64( _mm256_and_si256( b, select ), select ) );
+}
+
+inline __m256i mask_epi32( unsigned char byte )
+{
+    __m256i const select = _mm256_set_epi32( 128, 64, 32, 16, 8, 4, 2, 1 );
+    __m256i const b = _mm256_set1_epi32( byte );
+    return _mm256_cmpeq_epi32( _mm256_and_si256( b, select ), select );
+}
+
+inline double hsum( __m256d v )
+{
+    double r[4]; _mm256_storeu_pd( r, v );
+    return ( r[0] + r[1] ) + ( r[2] + r[3] );
+}
+
+inline double sum_column( double const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m256i const lo = _mm256_set_epi64x( 8, 4, 2, 1 );
+    __m256i const hi = _mm256_set_epi64x( 128, 64, 32, 16 );
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        s0 = _mm256_add_pd( s0, _mm256_and_pd( mask_pd( byte, lo ), _mm256_loadu_pd( values + i     ) ) );
+        s1 = _mm256_add_pd( s1, _mm256_and_pd( mask_pd( byte, hi ), _mm256_loadu_pd( values + i + 4 ) ) );
+    }
+    return hsum( _mm256_add_pd( s0, s1 ) ) + sum_scalar( values, bitmap, i, n );
+}
+
+inline long long sum_column( int const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m256i s = _mm256_setzero_si256();
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256i const v = _mm256_and_si256( mask_epi32( bitmap[ i / 8 ] ), _mm256_loadu_si256( reinterpret_cast<__m256i const *>( values + i ) ) );
+        s = _mm256_add_epi64( s, _mm256_cvtepi32_epi64( _mm256_castsi256_si128( v ) ) );
+        s = _mm256_add_epi64( s, _mm256_cvtepi32_epi64( _mm256_extracti128_si256( v, 1 ) ) );
+    }
+    long long r[4]; _mm256_storeu_si256( reinterpret_cast<__m256i *>( r ), s );
+    return ( r[0] + r[1] ) + ( r[2] + r[3] ) + sum_scalar( values, bitmap, i, n );
+}
+
+inline double min_column( double const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m256i const lo = _mm256_set_epi64x( 8, 4, 2, 1 );
+    __m256i const hi = _mm256_set_epi64x( 128, 64, 32, 16 );
+    __m256d const id = _mm256_set1_pd( min_identity<double>() );
+    __m256d m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        m = _mm256_min_pd( m, _mm256_blendv_pd( id, _mm256_loadu_pd( values + i     ), mask_pd( byte, lo ) ) );
+        m = _mm256_min_pd( m, _mm256_blendv_pd( id, _mm256_loadu_pd( values + i + 4 ), mask_pd( byte, hi ) ) );
+    }
+    double r[4]; _mm256_storeu_pd( r, m );
+    return min_scalar( values, bitmap, i, n, reduce_min( r, 4, min_identity<double>() ) );
+}
+
+inline double max_column( double const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m256i const lo = _mm256_set_epi64x( 8, 4, 2, 1 );
+    __m256i const hi = _mm256_set_epi64x( 128, 64, 32, 16 );
+    __m256d const id = _mm256_set1_pd( max_identity<double>() );
+    __m256d m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        m = _mm256_max_pd( m, _mm256_blendv_pd( id, _mm256_loadu_pd( values + i     ), mask_pd( byte, lo ) ) );
+        m = _mm256_max_pd( m, _mm256_blendv_pd( id, _mm256_loadu_pd( values + i + 4 ), mask_pd( byte, hi ) ) );
+    }
+    double r[4]; _mm256_storeu_pd( r, m );
+    return max_scalar( values, bitmap, i, n, reduce_max( r, 4, max_identity<double>() ) );
+}
+
+inline int min_column( int const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m256i const id = _mm256_set1_epi32( min_identity<int>() );
+    __m256i m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256i const v = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( values + i ) );
+        m = _mm256_min_epi32( m, _mm256_blendv_epi8( id, v, mask_epi32( bitmap[ i / 8 ] ) ) );
+    }
+    int r[8]; _mm256_storeu_si256( reinterpret_cast<__m256i *>( r ), m );
+    return min_scalar( values, bitmap, i, n, reduce_min( r, 8, min_identity<int>() ) );
+}
+
+inline int max_column( int const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m256i const id = _mm256_set1_epi32( max_identity<int>() );
+    __m256i m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __m256i const v = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( values + i ) );
+        m = _mm256_max_epi32( m, _mm256_blendv_epi8( id, v, mask_epi32( bitmap[ i / 8 ] ) ) );
+    }
+    int r[8]; _mm256_storeu_si256( reinterpret_cast<__m256i *>( r ), m );
+    return max_scalar( values, bitmap, i, n, reduce_max( r, 8, max_identity<int>() ) );
+}
+
+#elif optional_HAVE_SSE2
+
+// column kernels for double and int, eight elements per bitmap byte;
+// a mask of two doubles is formed from two equal 32-bit lanes:
+
+inline __m128d mask_pd( unsigned char byte, int bit )
+{
+    __m128i const select = _mm_set_epi32( bit << 1, bit << 1, bit, bit );
+    __m128i const b = _mm_set1_epi32( byte );
+    return _mm_castsi128_pd( _mm_cmpeq_epi32( _mm_and_si128( b, select ), select ) );
+}
+
+inline __m128i mask_epi32( unsigned char byte, int bit )
+{
+    __m128i const select = _mm_set_epi32( bit << 3, bit << 2, bit << 1, bit );
+    __m128i const b = _mm_set1_epi32( byte );
+    return _mm_cmpeq_epi32( _mm_and_si128( b, select ), select );
+}
+
+inline __m128d select_pd( __m128d mask, __m128d a, __m128d b )
+{
+    return _mm_or_pd( _mm_and_pd( mask, a ), _mm_andnot_pd( mask, b ) );
+}
+
+inline __m128i select_epi32( __m128i mask, __m128i a, __m128i b )
+{
+    return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+inline double sum_column( double const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        s0 = _mm_add_pd( s0, _mm_and_pd( mask_pd( byte,  1 ), _mm_loadu_pd( values + i     ) ) );
+        s1 = _mm_add_pd( s1, _mm_and_pd( mask_pd( byte,  4 ), _mm_loadu_pd( values + i + 2 ) ) );
+        s0 = _mm_add_pd( s0, _mm_and_pd( mask_pd( byte, 16 ), _mm_loadu_pd( values + i + 4 ) ) );
+        s1 = _mm_add_pd( s1, _mm_and_pd( mask_pd( byte, 64 ), _mm_loadu_pd( values + i + 6 ) ) );
+    }
+    double r[2]; _mm_storeu_pd( r, _mm_add_pd( s0, s1 ) );
+    return ( r[0] + r[1] ) + sum_scalar( values, bitmap, i, n );
+}
+
+inline __m128i add_epi32_to_epi64( __m128i s, __m128i v )
+{
+    __m128i const sign = _mm_srai_epi32( v, 31 );
+    s = _mm_add_epi64( s, _mm_unpacklo_epi32( v, sign ) );
+    return _mm_add_epi64( s, _mm_unpackhi_epi32( v, sign ) );
+}
+
+inline long long sum_column( int const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m128i s = _mm_setzero_si128();
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        s = add_epi32_to_epi64( s, _mm_and_si128( mask_epi32( byte,  1 ), _mm_loadu_si128( reinterpret_cast<__m128i const *>( values + i     ) ) ) );
+        s = add_epi32_to_epi64( s, _mm_and_si128( mask_epi32( byte, 16 ), _mm_loadu_si128( reinterpret_cast<__m128i const *>( values + i + 4 ) ) ) );
+    }
+    long long r[2]; _mm_storeu_si128( reinterpret_cast<__m128i *>( r ), s );
+    return ( r[0] + r[1] ) + sum_scalar( values, bitmap, i, n );
+}
+
+inline double min_column( double const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m128d const id = _mm_set1_pd( min_identity<double>() );
+    __m128d m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        for ( int k = 0; k < 4; ++k )
+            m = _mm_min_pd( m, select_pd( mask_pd( byte, 1 << ( 2 * k ) ), _mm_loadu_pd( values + i + 2 * k ), id ) );
+    }
+    double r[2]; _mm_storeu_pd( r, m );
+    return min_scalar( values, bitmap, i, n, reduce_min( r, 2, min_identity<double>() ) );
+}
+
+inline double max_column( double const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m128d const id = _mm_set1_pd( max_identity<double>() );
+    __m128d m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        for ( int k = 0; k < 4; ++k )
+            m = _mm_max_pd( m, select_pd( mask_pd( byte, 1 << ( 2 * k ) ), _mm_loadu_pd( values + i + 2 * k ), id ) );
+    }
+    double r[2]; _mm_storeu_pd( r, m );
+    return max_scalar( values, bitmap, i, n, reduce_max( r, 2, max_identity<double>() ) );
+}
+
+inline int min_column( int const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m128i const id = _mm_set1_epi32( min_identity<int>() );
+    __m128i m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        for ( int k = 0; k < 2; ++k )
+        {
+            __m128i const v = select_epi32( mask_epi32( byte, 1 << ( 4 * k ) ), _mm_loadu_si128( reinterpret_cast<__m128i const *>( values + i + 4 * k ) ), id );
+            m = select_epi32( _mm_cmplt_epi32( v, m ), v, m );
+        }
+    }
+    int r[4]; _mm_storeu_si128( reinterpret_cast<__m128i *>( r ), m );
+    return min_scalar( values, bitmap, i, n, reduce_min( r, 4, min_identity<int>() ) );
+}
+
+inline int max_column( int const * values, unsigned char const * bitmap, std::size_t n )
+{
+    __m128i const id = _mm_set1_epi32( max_identity<int>() );
+    __m128i m = id;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        for ( int k = 0; k < 2; ++k )
+        {
+            __m128i const v = select_epi32( mask_epi32( byte, 1 << ( 4 * k ) ), _mm_loadu_si128( reinterpret_cast<__m128i const *>( values + i + 4 * k ) ), id );
+            m = select_epi32( _mm_cmpgt_epi32( v, m ), v, m );
+        }
+    }
+    int r[4]; _mm_storeu_si128( reinterpret_cast<__m128i *>( r ), m );
+    return max_scalar( values, bitmap, i, n, reduce_max( r, 4, max_identity<int>() ) );
+}
+
+#endif // optional_HAVE_AVX2, optional_HAVE_SSE2
+
+} // namespace detail
+
+//
+// Reductions over a column of n values with a validity bitmap:
+//
+
+// number of engaged elements:
+
+inline std::size_t count( unsigned char const * bitmap, std::size_t n )
+{
+    std::size_t c = 0;
+    std::size_t i = 0;
+
+    for ( ; i + 64 <= n; i += 64 )
+    {
+        unsigned long long w;
+        std::memcpy( &w, bitmap + i / 8, sizeof w );
+        c += detail::popcount( w );
+    }
+    for ( ; i < n; ++i )
+    {
+        c += detail::test( bitmap, i );
+    }
+    return c;
+}
+
+// sum of the engaged values, accumulated in long long, unsigned long long or double:
+
+template< typename T >
+typename detail::sum_type<T>::type sum( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    return detail::sum_column( values, bitmap, n );
+}
+
+// smallest and largest engaged value, empty if there is none:
+
+template< typename T >
+optional<T> min( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    return count( bitmap, n ) ? optional<T>( detail::min_column( values, bitmap, n ) ) : optional<T>();
+}
+
+template< typename T >
+optional<T> max( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    return count( bitmap, n ) ? optional<T>( detail::max_column( values, bitmap, n ) ) : optional<T>();
+}
+
+// arithmetic mean of the engaged values, empty if there is none:
+
+template< typename T >
+optional<double> mean( T const * values, unsigned char const * bitmap, std::size_t n )
+{
+    std::size_t const c = count( bitmap, n );
+
+    return c ? optional<double>( static_cast<double>( sum( values, bitmap, n ) ) / static_cast<double>( c ) ) : optional<double>();
+}
+
+//
+// Reductions over an optional_vector:
+//
+
+template< typename T >
+std::size_t count( optional_vector<T> const & v )
+{
+    return count( v.bitmap(), v.size() );
+}
+
+template< typename T >
+typename detail::sum_type<T>::type sum( optional_vector<T> const & v )
+{
+    return sum( v.values(), v.bitmap(), v.size() );
+}
+
+template< typename T >
+optional<T> min( optional_vector<T> const & v )
+{
+    return min( v.values(), v.bitmap(), v.size() );
+}
+
+template< typename T >
+optional<T> max( optional_vector<T> const & v )
+{
+    return max( v.values(), v.bitmap(), v.size() );
+}
+
+template< typename T >
+optional<double> mean( optional_vector<T> const & v )
+{
+    return mean( v.values(), v.bitmap(), v.size() );
+}
+
+//
+// Reductions over a range of optional<T>:
+//
+
+template< typename InputIt >
+std::size_t count( InputIt first, InputIt last )
+{
+    std::size_t c = 0;
+    for ( ; first != last; ++first )
+    {
+        c += (*first).has_value();
+    }
+    return c;
+}
+
+template< typename InputIt >
+typename detail::sum_type< typename detail::optional_value_type<InputIt>::type >::type
+sum( InputIt first, InputIt last )
+{
+    typedef typename detail::sum_type< typename detail::optional_value_type<InputIt>::type >::type S;
+
+    S s = S();
+    for ( ; first != last; ++first )
+    {
+        s += static_cast<S>( detail::value_or_zero( *first ) );
+    }
+    return s;
+}
+
+template< typename InputIt >
+optional< typename detail::optional_value_type<InputIt>::type >
+min( InputIt first, InputIt last )
+{
+    typedef typename detail::optional_value_type<InputIt>::type T;
+
+    T m = detail::min_identity<T>();
+    bool any = false;
+    for ( ; first != last; ++first )
+    {
+        bool const on = (*first).has_value();
+        T const v = detail::value_or_zero( *first );
+        m = ( on & ( v < m ) ) ? v : m;
+        any = any | on;
+    }
+    return any ? optional<T>( m ) : optional<T>();
+}
+
+template< typename InputIt >
+optional< typename detail::optional_value_type<InputIt>::type >
+max( InputIt first, InputIt last )
+{
+    typedef typename detail::optional_value_type<InputIt>::type T;
+
+    T m = detail::max_identity<T>();
+    bool any = false;
+    for ( ; first != last; ++first )
+    {
+        bool const on = (*first).has_value();
+        T const v = detail::value_or_zero( *first );
+        m = ( on & ( m < v ) ) ? v : m;
+        any = any | on;
+    }
+    return any ? optional<T>( m ) : optional<T>();
+}
+
+template< typename InputIt >
+optional<double> mean( InputIt first, InputIt last )
+{
+    typedef typename detail::sum_type< typename detail::optional_value_type<InputIt>::type >::type S;
+
+    S s = S();
+    std::size_t c = 0;
+    for ( ; first != last; ++first )
+    {
+        s += static_cast<S>( detail::value_or_zero( *first ) );
+        c += (*first).has_value();
+    }
+    return c ? optional<double>( static_cast<double>( s ) / static_cast<double>( c ) ) : optional<double>();
+}
+
+//
+// Compaction of the engaged values into a dense sequence, and its inverse:
+//
+
+namespace detail {
+
+// 64 bits of a bitmap, element i + k in bit k:
+
+inline unsigned long long load_word( unsigned char const * bitmap )
+{
+    unsigned long long w = 0;
+    for ( int k = 0; k < 8; ++k )
+        w |= static_cast<unsigned long long>( bitmap[k] ) << ( 8 * k );
+    return w;
+}
+
+// number of trailing zero bits of a non-zero 64-bit word:
+
+inline std::size_t countr_zero( unsigned long long w )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast<std::size_t>( __builtin_ctzll( w ) );
+#else
+    return popcount( ( w & ( ~w + 1 ) ) - 1 );
+#endif
+}
+
+// scalar column kernels for elements [first, n), of which 'remaining' are engaged;
+// the loops stop at the last engaged element so that they never write, or read,
+// beyond the dense sequence:
+
+template< typename T >
+T * compact_scalar( T const * values, unsigned char const * bitmap, std::size_t first, T * out, std::size_t remaining )
+{
+    std::size_t i = first;
+    std::size_t k = 0;
+    for ( ; i % 8 != 0 && k < remaining; ++i )
+    {
+        out[k] = values[i];
+        k += test( bitmap, i );
+    }
+    // while at least eight engaged elements remain, a byte of the bitmap at a time:
+    for ( ; k + 8 <= remaining; i += 8 )
+    {
+        unsigned int const byte = bitmap[ i / 8 ];
+        for ( unsigned int j = 0; j < 8; ++j )
+        {
+            out[k] = values[ i + j ];
+            k += ( byte >> j ) & 1u;
+        }
+    }
+    for ( ; k < remaining; ++i )
+    {
+        out[k] = values[i];
+        k += test( bitmap, i );
+    }
+    return out + remaining;
+}
+
+template< typename T >
+T * expand_scalar( T const * dense, unsigned char const * bitmap, std::size_t first, std::size_t n, T * values, std::size_t remaining )
+{
+    std::size_t i = first;
+    for ( std::size_t k = 0; k < remaining; ++i )
+    {
+        T const v = dense[k];
+        bool const on = test( bitmap, i );
+        values[i] = on ? v : T();
+        k += on;
+    }
+    std::fill( values + i, values + n, T() );
+    return values + n;
+}
+
+// column kernels, generic:
+
+template< typename T >
+T * compact_column( T const * values, unsigned char const * bitmap, std::size_t /*n*/, T * out, std::size_t total )
+{
+    return compact_scalar( values, bitmap, 0, out, total );
+}
+
+template< typename T >
+T * expand_column( T const * dense, unsigned char const * bitmap, std::size_t n, T * values, std::size_t total )
+{
+    return expand_scalar( dense, bitmap, 0, n, values, total );
+}
+
+#if optional_HAVE_AVX512
+
+// column kernels for double and int, with vcompress and vexpand:
+
+inline int * compact_column( int const * values, unsigned char const * bitmap, std::size_t n, int * out, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 16 <= n; i += 16 )
+    {
+        __mmask16 const m = static_cast<__mmask16>( bitmap[ i / 8 ] | bitmap[ i / 8 + 1 ] << 8 );
+        _mm512_mask_compressstoreu_epi32( out + k, m, _mm512_loadu_si512( values + i ) );
+        k += popcount( m );
+    }
+    return compact_scalar( values, bitmap, i, out + k, total - k );
+}
+
+inline double * compact_column( double const * values, unsigned char const * bitmap, std::size_t n, double * out, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __mmask8 const m = bitmap[ i / 8 ];
+        _mm512_mask_compressstoreu_pd( out + k, m, _mm512_loadu_pd( values + i ) );
+        k += popcount( m );
+    }
+    return compact_scalar( values, bitmap, i, out + k, total - k );
+}
+
+inline int * expand_column( int const * dense, unsigned char const * bitmap, std::size_t n, int * values, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 16 <= n; i += 16 )
+    {
+        __mmask16 const m = static_cast<__mmask16>( bitmap[ i / 8 ] | bitmap[ i / 8 + 1 ] << 8 );
+        _mm512_storeu_si512( values + i, _mm512_maskz_expandloadu_epi32( m, dense + k ) );
+        k += popcount( m );
+    }
+    return expand_scalar( dense + k, bitmap, i, n, values, total - k );
+}
+
+inline double * expand_column( double const * dense, unsigned char const * bitmap, std::size_t n, double * values, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        __mmask8 const m = bitmap[ i / 8 ];
+        _mm512_storeu_pd( values + i, _mm512_maskz_expandloadu_pd( m, dense + k ) );
+        k += popcount( m );
+    }
+    return expand_scalar( dense + k, bitmap, i, n, values, total - k );
+}
+
+#elif optional_HAVE_AVX2
+
+// column kernels for double and int, with permutation tables indexed by a
+// bitmap byte or nibble; an entry holds the eight 32-bit source lanes in
+// its nibbles, least significant nibble first. The full-width loads and
+// stores of the dense sequence stay within its 'total' elements.
+
+inline unsigned int compact_permutation32( unsigned char byte )
+{
+    static unsigned int const table[256] =
+    {
+        0x00000000u, 0x00000000u, 0x00000001u, 0x00000010u, 0x00000002u, 0x00000020u, 0x00000021u, 0x00000210u,
+        0x00000003u, 0x00000030u, 0x00000031u, 0x00000310u, 0x00000032u, 0x00000320u, 0x00000321u, 0x00003210u,
+        0x00000004u, 0x00000040u, 0x00000041u, 0x00000410u, 0x00000042u, 0x00000420u, 0x00000421u, 0x00004210u,
+        0x00000043u, 0x00000430u, 0x00000431u, 0x00004310u, 0x00000432u, 0x00004320u, 0x00004321u, 0x00043210u,
+        0x00000005u, 0x00000050u, 0x00000051u, 0x00000510u, 0x00000052u, 0x00000520u, 0x00000521u, 0x00005210u,
+        0x00000053u, 0x00000530u, 0x00000531u, 0x00005310u, 0x00000532u, 0x00005320u, 0x00005321u, 0x00053210u,
+        0x00000054u, 0x00000540u, 0x00000541u, 0x00005410u, 0x00000542u, 0x00005420u, 0x00005421u, 0x00054210u,
+        0x00000543u, 0x00005430u, 0x00005431u, 0x00054310u, 0x00005432u, 0x00054320u, 0x00054321u, 0x00543210u,
+        0x00000006u, 0x00000060u, 0x00000061u, 0x00000610u, 0x00000062u, 0x00000620u, 0x00000621u, 0x00006210u,
+        0x00000063u, 0x00000630u, 0x00000631u, 0x00006310u, 0x00000632u, 0x00006320u, 0x00006321u, 0x00063210u,
+        0x00000064u, 0x00000640u, 0x00000641u, 0x00006410u, 0x00000642u, 0x00006420u, 0x00006421u, 0x00064210u,
+        0x00000643u, 0x00006430u, 0x00006431u, 0x00064310u, 0x00006432u, 0x00064320u, 0x00064321u, 0x00643210u,
+        0x00000065u, 0x00000650u, 0x00000651u, 0x00006510u, 0x00000652u, 0x00006520u, 0x00006521u, 0x00065210u,
+        0x00000653u, 0x00006530u, 0x00006531u, 0x00065310u, 0x00006532u, 0x00065320u, 0x00065321u, 0x00653210u,
+        0x00000654u, 0x00006540u, 0x00006541u, 0x00065410u, 0x00006542u, 0x00065420u, 0x00065421u, 0x00654210u,
+        0x00006543u, 0x00065430u, 0x00065431u, 0x00654310u, 0x00065432u, 0x00654320u, 0x00654321u, 0x06543210u,
+        0x00000007u, 0x00000070u, 0x00000071u, 0x00000710u, 0x00000072u, 0x00000720u, 0x00000721u, 0x00007210u,
+        0x00000073u, 0x00000730u, 0x00000731u, 0x00007310u, 0x00000732u, 0x00007320u, 0x00007321u, 0x00073210u,
+        0x00000074u, 0x00000740u, 0x00000741u, 0x00007410u, 0x00000742u, 0x00007420u, 0x00007421u, 0x00074210u,
+        0x00000743u, 0x00007430u, 0x00007431u, 0x00074310u, 0x00007432u, 0x00074320u, 0x00074321u, 0x00743210u,
+        0x00000075u, 0x00000750u, 0x00000751u, 0x00007510u, 0x00000752u, 0x00007520u, 0x00007521u, 0x00075210u,
+        0x00000753u, 0x00007530u, 0x00007531u, 0x00075310u, 0x00007532u, 0x00075320u, 0x00075321u, 0x00753210u,
+        0x00000754u, 0x00007540u, 0x00007541u, 0x00075410u, 0x00007542u, 0x00075420u, 0x00075421u, 0x00754210u,
+        0x00007543u, 0x00075430u, 0x00075431u, 0x00754310u, 0x00075432u, 0x00754320u, 0x00754321u, 0x07543210u,
+        0x00000076u, 0x00000760u, 0x00000761u, 0x00007610u, 0x00000762u, 0x00007620u, 0x00007621u, 0x00076210u,
+        0x00000763u, 0x00007630u, 0x00007631u, 0x00076310u, 0x00007632u, 0x00076320u, 0x00076321u, 0x00763210u,
+        0x00000764u, 0x00007640u, 0x00007641u, 0x00076410u, 0x00007642u, 0x00076420u, 0x00076421u, 0x00764210u,
+        0x00007643u, 0x00076430u, 0x00076431u, 0x00764310u, 0x00076432u, 0x00764320u, 0x00764321u, 0x07643210u,
+        0x00000765u, 0x00007650u, 0x00007651u, 0x00076510u, 0x00007652u, 0x00076520u, 0x00076521u, 0x00765210u,
+        0x00007653u, 0x00076530u, 0x00076531u, 0x00765310u, 0x00076532u, 0x00765320u, 0x00765321u, 0x07653210u,
+        0x00007654u, 0x00076540u, 0x00076541u, 0x00765410u, 0x00076542u, 0x00765420u, 0x00765421u, 0x07654210u,
+        0x00076543u, 0x00765430u, 0x00765431u, 0x07654310u, 0x00765432u, 0x07654320u, 0x07654321u, 0x76543210u
+    };
+    return table[ byte ];
+}
+
+inline unsigned int expand_permutation32( unsigned char byte )
+{
+    static unsigned int const table[256] =
+    {
+        0x00000000u, 0x00000000u, 0x00000000u, 0x00000010u, 0x00000000u, 0x00000100u, 0x00000100u, 0x00000210u,
+        0x00000000u, 0x00001000u, 0x00001000u, 0x00002010u, 0x00001000u, 0x00002100u, 0x00002100u, 0x00003210u,
+        0x00000000u, 0x00010000u, 0x00010000u, 0x00020010u, 0x00010000u, 0x00020100u, 0x00020100u, 0x00030210u,
+        0x00010000u, 0x00021000u, 0x00021000u, 0x00032010u, 0x00021000u, 0x00032100u, 0x00032100u, 0x00043210u,
+        0x00000000u, 0x00100000u, 0x00100000u, 0x00200010u, 0x00100000u, 0x00200100u, 0x00200100u, 0x00300210u,
+        0x00100000u, 0x00201000u, 0x00201000u, 0x00302010u, 0x00201000u, 0x00302100u, 0x00302100u, 0x00403210u,
+        0x00100000u, 0x00210000u, 0x00210000u, 0x00320010u, 0x00210000u, 0x00320100u, 0x00320100u, 0x00430210u,
+        0x00210000u, 0x00321000u, 0x00321000u, 0x00432010u, 0x00321000u, 0x00432100u, 0x00432100u, 0x00543210u,
+        0x00000000u, 0x01000000u, 0x01000000u, 0x02000010u, 0x01000000u, 0x02000100u, 0x02000100u, 0x03000210u,
+        0x01000000u, 0x02001000u, 0x02001000u, 0x03002010u, 0x02001000u, 0x03002100u, 0x03002100u, 0x04003210u,
+        0x01000000u, 0x02010000u, 0x02010000u, 0x03020010u, 0x02010000u, 0x03020100u, 0x03020100u, 0x04030210u,
+        0x02010000u, 0x03021000u, 0x03021000u, 0x04032010u, 0x03021000u, 0x04032100u, 0x04032100u, 0x05043210u,
+        0x01000000u, 0x02100000u, 0x02100000u, 0x03200010u, 0x02100000u, 0x03200100u, 0x03200100u, 0x04300210u,
+        0x02100000u, 0x03201000u, 0x03201000u, 0x04302010u, 0x03201000u, 0x04302100u, 0x04302100u, 0x05403210u,
+        0x02100000u, 0x03210000u, 0x03210000u, 0x04320010u, 0x03210000u, 0x04320100u, 0x04320100u, 0x05430210u,
+        0x03210000u, 0x04321000u, 0x04321000u, 0x05432010u, 0x04321000u, 0x05432100u, 0x05432100u, 0x06543210u,
+        0x00000000u, 0x10000000u, 0x10000000u, 0x20000010u, 0x10000000u, 0x20000100u, 0x20000100u, 0x30000210u,
+        0x10000000u, 0x20001000u, 0x20001000u, 0x30002010u, 0x20001000u, 0x30002100u, 0x30002100u, 0x40003210u,
+        0x10000000u, 0x20010000u, 0x20010000u, 0x30020010u, 0x20010000u, 0x30020100u, 0x30020100u, 0x40030210u,
+        0x20010000u, 0x30021000u, 0x30021000u, 0x40032010u, 0x30021000u, 0x40032100u, 0x40032100u, 0x50043210u,
+        0x10000000u, 0x20100000u, 0x20100000u, 0x30200010u, 0x20100000u, 0x30200100u, 0x30200100u, 0x40300210u,
+        0x20100000u, 0x30201000u, 0x30201000u, 0x40302010u, 0x30201000u, 0x40302100u, 0x40302100u, 0x50403210u,
+        0x20100000u, 0x30210000u, 0x30210000u, 0x40320010u, 0x30210000u, 0x40320100u, 0x40320100u, 0x50430210u,
+        0x30210000u, 0x40321000u, 0x40321000u, 0x50432010u, 0x40321000u, 0x50432100u, 0x50432100u, 0x60543210u,
+        0x10000000u, 0x21000000u, 0x21000000u, 0x32000010u, 0x21000000u, 0x32000100u, 0x32000100u, 0x43000210u,
+        0x21000000u, 0x32001000u, 0x32001000u, 0x43002010u, 0x32001000u, 0x43002100u, 0x43002100u, 0x54003210u,
+        0x21000000u, 0x32010000u, 0x32010000u, 0x43020010u, 0x32010000u, 0x43020100u, 0x43020100u, 0x54030210u,
+        0x32010000u, 0x43021000u, 0x43021000u, 0x54032010u, 0x43021000u, 0x54032100u, 0x54032100u, 0x65043210u,
+        0x21000000u, 0x32100000u, 0x32100000u, 0x43200010u, 0x32100000u, 0x43200100u, 0x43200100u, 0x54300210u,
+        0x32100000u, 0x43201000u, 0x43201000u, 0x54302010u, 0x43201000u, 0x54302100u, 0x54302100u, 0x65403210u,
+        0x32100000u, 0x43210000u, 0x43210000u, 0x54320010u, 0x43210000u, 0x54320100u, 0x54320100u, 0x65430210u,
+        0x43210000u, 0x54321000u, 0x54321000u, 0x65432010u, 0x54321000u, 0x65432100u, 0x65432100u, 0x76543210u
+    };
+    return table[ byte ];
+}
+
+inline unsigned int compact_permutation64( unsigned int nibble )
+{
+    static unsigned int const table[16] =
+    {
+        0x00000000u, 0x00000010u, 0x00000032u, 0x00003210u, 0x00000054u, 0x00005410u, 0x00005432u, 0x00543210u,
+        0x00000076u, 0x00007610u, 0x00007632u, 0x00763210u, 0x00007654u, 0x00765410u, 0x00765432u, 0x76543210u
+    };
+    return table[ nibble ];
+}
+
+inline unsigned int expand_permutation64( unsigned int nibble )
+{
+    static unsigned int const table[16] =
+    {
+        0x10101010u, 0x10101010u, 0x10101010u, 0x10103210u, 0x10101010u, 0x10321010u, 0x10321010u, 0x10543210u,
+        0x10101010u, 0x32101010u, 0x32101010u, 0x54103210u, 0x32101010u, 0x54321010u, 0x54321010u, 0x76543210u
+    };
+    return table[ nibble ];
+}
+
+inline __m256i permutation( unsigned int entry )
+{
+    __m256i const shift = _mm256_set_epi32( 28, 24, 20, 16, 12, 8, 4, 0 );
+    return _mm256_and_si256( _mm256_srlv_epi32( _mm256_set1_epi32( static_cast<int>( entry ) ), shift ), _mm256_set1_epi32( 0xf ) );
+}
+
+inline __m256d permute_pd( __m256d v, unsigned int entry )
+{
+    return _mm256_castsi256_pd( _mm256_permutevar8x32_epi32( _mm256_castpd_si256( v ), permutation( entry ) ) );
+}
+
+inline int * compact_column( int const * values, unsigned char const * bitmap, std::size_t n, int * out, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 8 <= n && k + 8 <= total; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        __m256i const v = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( values + i ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( out + k ), _mm256_permutevar8x32_epi32( v, permutation( compact_permutation32( byte ) ) ) );
+        k += popcount( byte );
+    }
+    return compact_scalar( values, bitmap, i, out + k, total - k );
+}
+
+inline double * compact_column( double const * values, unsigned char const * bitmap, std::size_t n, double * out, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 8 <= n && k + 8 <= total; i += 8 )
+    {
+        unsigned int const lo = bitmap[ i / 8 ] & 0xfu;
+        unsigned int const hi = bitmap[ i / 8 ] >> 4u;
+        _mm256_storeu_pd( out + k, permute_pd( _mm256_loadu_pd( values + i     ), compact_permutation64( lo ) ) );
+        k += popcount( lo );
+        _mm256_storeu_pd( out + k, permute_pd( _mm256_loadu_pd( values + i + 4 ), compact_permutation64( hi ) ) );
+        k += popcount( hi );
+    }
+    return compact_scalar( values, bitmap, i, out + k, total - k );
+}
+
+inline int * expand_column( int const * dense, unsigned char const * bitmap, std::size_t n, int * values, std::size_t total )
+{
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 8 <= n && k + 8 <= total; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        __m256i const v = _mm256_loadu_si256( reinterpret_cast<__m256i const *>( dense + k ) );
+        __m256i const e = _mm256_permutevar8x32_epi32( v, permutation( expand_permutation32( byte ) ) );
+        _mm256_storeu_si256( reinterpret_cast<__m256i *>( values + i ), _mm256_and_si256( mask_epi32( byte ), e ) );
+        k += popcount( byte );
+    }
+    return expand_scalar( dense + k, bitmap, i, n, values, total - k );
+}
+
+inline double * expand_column( double const * dense, unsigned char const * bitmap, std::size_t n, double * values, std::size_t total )
+{
+    __m256i const select_lo = _mm256_set_epi64x( 8, 4, 2, 1 );
+    __m256i const select_hi = _mm256_set_epi64x( 128, 64, 32, 16 );
+
+    std::size_t i = 0;
+    std::size_t k = 0;
+    for ( ; i + 8 <= n && k + 8 <= total; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        unsigned int const lo = byte & 0xfu;
+        unsigned int const hi = byte >> 4u;
+        _mm256_storeu_pd( values + i    , _mm256_and_pd( mask_pd( byte, select_lo ), permute_pd( _mm256_loadu_pd( dense + k ), expand_permutation64( lo ) ) ) );
+        k += popcount( lo );
+        _mm256_storeu_pd( values + i + 4, _mm256_and_pd( mask_pd( byte, select_hi ), permute_pd( _mm256_loadu_pd( dense + k ), expand_permutation64( hi ) ) ) );
+        k += popcount( hi );
+    }
+    return expand_scalar( dense + k, bitmap, i, n, values, total - k );
+}
+
+#endif // optional_HAVE_AVX512, optional_HAVE_AVX2
+
+} // namespace detail
+
+// copy the engaged values of a column to out, return the end of the dense sequence:
+
+template< typename T >
+T * compact( T const * values, unsigned char const * bitmap, std::size_t n, T * out )
+{
+    return detail::compact_column( values, bitmap, n, out, count( bitmap, n ) );
+}
+
+// write the indices of the engaged elements of a column to out:
+
+template< typename OutputIt >
+OutputIt compact_indices( unsigned char const * bitmap, std::size_t n, OutputIt out )
+{
+    std::size_t i = 0;
+    for ( ; i + 64 <= n; i += 64 )
+    {
+        for ( unsigned long long w = detail::load_word( bitmap + i / 8 ); w; w &= w - 1 )
+        {
+            *out++ = i + detail::countr_zero( w );
+        }
+    }
+    for ( ; i < n; ++i )
+    {
+        if ( detail::test( bitmap, i ) )
+            *out++ = i;
+    }
+    return out;
+}
+
+// scatter the dense values to the engaged elements of a column of n values,
+// value-initialize the disengaged elements, return the end of the column:
+
+template< typename T >
+T * expand( T const * dense, unsigned char const * bitmap, std::size_t n, T * values )
+{
+    return detail::expand_column( dense, bitmap, n, values, count( bitmap, n ) );
+}
+
+template< typename T >
+T * expand( T * dense, unsigned char const * bitmap, std::size_t n, T * values )
+{
+    return expand( const_cast<T const *>( dense ), bitmap, n, values );
+}
+
+template< typename T >
+T * compact( optional_vector<T> const & v, T * out )
+{
+    return compact( v.values(), v.bitmap(), v.size(), out );
+}
+
+template< typename T, typename OutputIt >
+OutputIt compact_indices( optional_vector<T> const & v, OutputIt out )
+{
+    return compact_indices( v.bitmap(), v.size(), out );
+}
+
+// copy the engaged values of a range of optional<T> to out; the values are
+// gathered without a branch per element into a buffer of 64 elements:
+
+template< typename InputIt, typename OutputIt >
+OutputIt compact( InputIt first, InputIt last, OutputIt out )
+{
+    typedef typename detail::optional_value_type<InputIt>::type T;
+
+    T buffer[64];
+    while ( first != last )
+    {
+        std::size_t k = 0;
+        for ( std::size_t i = 0; i < 64 && first != last; ++i, ++first )
+        {
+            buffer[k] = detail::value_or_zero( *first );
+            k += (*first).has_value();
+        }
+        out = std::copy( buffer, buffer + k, out );
+    }
+    return out;
+}
+
+// write the indices of the engaged elements of a range of optional<T> to out:
+
+template< typename InputIt, typename OutputIt >
+OutputIt compact_indices( InputIt first, InputIt last, OutputIt out )
+{
+    std::size_t buffer[64];
+    std::size_t index = 0;
+    while ( first != last )
+    {
+        std::size_t k = 0;
+        for ( std::size_t i = 0; i < 64 && first != last; ++i, ++first, ++index )
+        {
+            buffer[k] = index;
+            k += (*first).has_value();
+        }
+        out = std::copy( buffer, buffer + k, out );
+    }
+    return out;
+}
+
+// write n optional<T> to out, engaged with the next dense value where the
+// bitmap is set and disengaged otherwise:
+
+template< typename InputIt, typename OutputIt >
+OutputIt expand( InputIt dense, unsigned char const * bitmap, std::size_t n, OutputIt out )
+{
+    typedef typename std::iterator_traits<InputIt>::value_type T;
+
+    for ( std::size_t i = 0; i < n; ++i, ++out )
+    {
+        if ( detail::test( bitmap, i ) )
+            *out = optional<T>( *dense++ );
+        else
+            *out = optional<T>();
+    }
+    return out;
+}
+
+//
+// Element-wise operations with null propagation: the result is engaged where
+// both operands are engaged. The validity bitmap is the bitwise and of those
+// of the operands and the operation is performed on all values unconditionally;
+// the result of a disengaged element is value-initialized. An integer division
+// by zero yields a disengaged element; a floating-point division follows IEEE.
+//
+
+namespace detail {
+
+#if optional_HAVE_AVX2 || optional_HAVE_SSE2
+
+// vector registers of double and int, with the lane masks of a bitmap byte
+// in 'parts' of 'lanes' elements, and the selection of lanes by a mask:
+
+template< typename T > struct simd;
+
+#if optional_HAVE_AVX2
+
+template<>
+struct simd< double >
+{
+    typedef __m256d type;
+    enum { lanes = 4 };
+
+    static type load( double const * p ) { return _mm256_loadu_pd( p ); }
+    static void store( double * p, type v ) { _mm256_storeu_pd( p, v ); }
+    static type mask( unsigned char byte, int part ) { return mask_pd( byte, part ? _mm256_set_epi64x( 128, 64, 32, 16 ) : _mm256_set_epi64x( 8, 4, 2, 1 ) ); }
+    static type zero_unless( type m, type v ) { return _mm256_and_pd( m, v ); }
+    static type select( type m, type x, type y ) { return _mm256_blendv_pd( y, x, m ); }
+    static type broadcast( double x ) { return _mm256_set1_pd( x ); }
+    static unsigned int bits( type m ) { return static_cast<unsigned int>( _mm256_movemask_pd( m ) ); }
+};
+
+template<>
+struct simd< int >
+{
+    typedef __m256i type;
+    enum { lanes = 8 };
+
+    static type load( int const * p ) { return _mm256_loadu_si256( reinterpret_cast<__m256i const *>( p ) ); }
+    static void store( int * p, type v ) { _mm256_storeu_si256( reinterpret_cast<__m256i *>( p ), v ); }
+    static type mask( unsigned char byte, int ) { return mask_epi32( byte ); }
+    static type zero_unless( type m, type v ) { return _mm256_and_si256( m, v ); }
+    static type select( type m, type x, type y ) { return _mm256_blendv_epi8( y, x, m ); }
+    static type broadcast( int x ) { return _mm256_set1_epi32( x ); }
+    static unsigned int bits( type m ) { return static_cast<unsigned int>( _mm256_movemask_ps( _mm256_castsi256_ps( m ) ) ); }
+};
+
+inline __m256d vadd( __m256d x, __m256d y ) { return _mm256_add_pd( x, y ); }
+inline __m256d vsub( __m256d x, __m256d y ) { return _mm256_sub_pd( x, y ); }
+inline __m256d vmul( __m256d x, __m256d y ) { return _mm256_mul_pd( x, y ); }
+inline __m256d vdiv( __m256d x, __m256d y ) { return _mm256_div_pd( x, y ); }
+inline __m256d vmin( __m256d x, __m256d y ) { return _mm256_min_pd( x, y ); }
+inline __m256d vmax( __m256d x, __m256d y ) { return _mm256_max_pd( x, y ); }
+
+inline __m256d vcmpeq( __m256d x, __m256d y ) { return _mm256_cmp_pd( x, y, _CMP_EQ_OQ  ); }
+inline __m256d vcmpne( __m256d x, __m256d y ) { return _mm256_cmp_pd( x, y, _CMP_NEQ_UQ ); }
+inline __m256d vcmplt( __m256d x, __m256d y ) { return _mm256_cmp_pd( x, y, _CMP_LT_OQ  ); }
+inline __m256d vcmple( __m256d x, __m256d y ) { return _mm256_cmp_pd( x, y, _CMP_LE_OQ  ); }
+inline __m256d vcmpgt( __m256d x, __m256d y ) { return _mm256_cmp_pd( x, y, _CMP_GT_OQ  ); }
+inline __m256d vcmpge( __m256d x, __m256d y ) { return _mm256_cmp_pd( x, y, _CMP_GE_OQ  ); }
+
+inline __m256i vadd( __m256i x, __m256i y ) { return _mm256_add_epi32( x, y ); }
+inline __m256i vsub( __m256i x, __m256i y ) { return _mm256_sub_epi32( x, y ); }
+inline __m256i vmul( __m256i x, __m256i y ) { return _mm256_mullo_epi32( x, y ); }
+inline __m256i vmin( __m256i x, __m256i y ) { return _mm256_min_epi32( x, y ); }
+inline __m256i vmax( __m256i x, __m256i y ) { return _mm256_max_epi32( x, y ); }
+inline __m256i vnot( __m256i x ) { return _mm256_xor_si256( x, _mm256_set1_epi32( -1 ) ); }
+
+inline __m256i vcmpeq( __m256i x, __m256i y ) { return _mm256_cmpeq_epi32( x, y ); }
+inline __m256i vcmpgt( __m256i x, __m256i y ) { return _mm256_cmpgt_epi32( x, y ); }
+
+#else // optional_HAVE_SSE2
+
+template<>
+struct simd< double >
+{
+    typedef __m128d type;
+    enum { lanes = 2 };
+
+    static type load( double const * p ) { return _mm_loadu_pd( p ); }
+    static void store( double * p, type v ) { _mm_storeu_pd( p, v ); }
+    static type mask( unsigned char byte, int part ) { return mask_pd( byte, 1 << ( 2 * part ) ); }
+    static type zero_unless( type m, type v ) { return _mm_and_pd( m, v ); }
+    static type select( type m, type x, type y ) { return select_pd( m, x, y ); }
+    static type broadcast( double x ) { return _mm_set1_pd( x ); }
+    static unsigned int bits( type m ) { return static_cast<unsigned int>( _mm_movemask_pd( m ) ); }
+};
+
+template<>
+struct simd< int >
+{
+    typedef __m128i type;
+    enum { lanes = 4 };
+
+    static type load( int const * p ) { return _mm_loadu_si128( reinterpret_cast<__m128i const *>( p ) ); }
+    static void store( int * p, type v ) { _mm_storeu_si128( reinterpret_cast<__m128i *>( p ), v ); }
+    static type mask( unsigned char byte, int part ) { return mask_epi32( byte, 1 << ( 4 * part ) ); }
+    static type zero_unless( type m, type v ) { return _mm_and_si128( m, v ); }
+    static type select( type m, type x, type y ) { return select_epi32( m, x, y ); }
+    static type broadcast( int x ) { return _mm_set1_epi32( x ); }
+    static unsigned int bits( type m ) { return static_cast<unsigned int>( _mm_movemask_ps( _mm_castsi128_ps( m ) ) ); }
+};
+
+inline __m128d vadd( __m128d x, __m128d y ) { return _mm_add_pd( x, y ); }
+inline __m128d vsub( __m128d x, __m128d y ) { return _mm_sub_pd( x, y ); }
+inline __m128d vmul( __m128d x, __m128d y ) { return _mm_mul_pd( x, y ); }
+inline __m128d vdiv( __m128d x, __m128d y ) { return _mm_div_pd( x, y ); }
+inline __m128d vmin( __m128d x, __m128d y ) { return _mm_min_pd( x, y ); }
+inline __m128d vmax( __m128d x, __m128d y ) { return _mm_max_pd( x, y ); }
+
+inline __m128d vcmpeq( __m128d x, __m128d y ) { return _mm_cmpeq_pd ( x, y ); }
+inline __m128d vcmpne( __m128d x, __m128d y ) { return _mm_cmpneq_pd( x, y ); }
+inline __m128d vcmplt( __m128d x, __m128d y ) { return _mm_cmplt_pd ( x, y ); }
+inline __m128d vcmple( __m128d x, __m128d y ) { return _mm_cmple_pd ( x, y ); }
+inline __m128d vcmpgt( __m128d x, __m128d y ) { return _mm_cmpgt_pd ( x, y ); }
+inline __m128d vcmpge( __m128d x, __m128d y ) { return _mm_cmpge_pd ( x, y ); }
+
+// SSE2 lacks the multiplication, minimum and maximum of 32-bit integers:
+
+inline __m128i vadd( __m128i x, __m128i y ) { return _mm_add_epi32( x, y ); }
+inline __m128i vsub( __m128i x, __m128i y ) { return _mm_sub_epi32( x, y ); }
+inline __m128i vmin( __m128i x, __m128i y ) { return select_epi32( _mm_cmplt_epi32( x, y ), x, y ); }
+inline __m128i vmax( __m128i x, __m128i y ) { return select_epi32( _mm_cmpgt_epi32( x, y ), x, y ); }
+inline __m128i vnot( __m128i x ) { return _mm_xor_si128( x, _mm_set1_epi32( -1 ) ); }
+
+inline __m128i vmul( __m128i x, __m128i y )
+{
+    __m128i const even = _mm_mul_epu32( x, y );
+    __m128i const odd  = _mm_mul_epu32( _mm_srli_si128( x, 4 ), _mm_srli_si128( y, 4 ) );
+    return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+inline __m128i vcmpeq( __m128i x, __m128i y ) { return _mm_cmpeq_epi32( x, y ); }
+inline __m128i vcmpgt( __m128i x, __m128i y ) { return _mm_cmpgt_epi32( x, y ); }
+
+#endif // optional_HAVE_AVX2
+
+// remaining comparisons of int:
+
+inline simd<int>::type vcmpne( simd<int>::type x, simd<int>::type y ) { return vnot( vcmpeq( x, y ) ); }
+inline simd<int>::type vcmplt( simd<int>::type x, simd<int>::type y ) { return vcmpgt( y, x ); }
+inline simd<int>::type vcmple( simd<int>::type x, simd<int>::type y ) { return vnot( vcmpgt( x, y ) ); }
+inline simd<int>::type vcmpge( simd<int>::type x, simd<int>::type y ) { return vnot( vcmpgt( y, x ) ); }
+
+#endif // optional_HAVE_AVX2 || optional_HAVE_SSE2
+
+// operations:
+
+struct op_add
+{
+    template< typename T > static T apply( T x, T y ) { return static_cast<T>( x + y ); }
+    template< typename T > static bool defined( T, T ) { return true; }
+    template< typename V > static V vapply( V x, V y ) { return vadd( x, y ); }
+};
+
+struct op_sub
+{
+    template< typename T > static T apply( T x, T y ) { return static_cast<T>( x - y ); }
+    template< typename T > static bool defined( T, T ) { return true; }
+    template< typename V > static V vapply( V x, V y ) { return vsub( x, y ); }
+};
+
+struct op_mul
+{
+    template< typename T > static T apply( T x, T y ) { return static_cast<T>( x * y ); }
+    template< typename T > static bool defined( T, T ) { return true; }
+    template< typename V > static V vapply( V x, V y ) { return vmul( x, y ); }
+};
+
+struct op_div
+{
+    template< typename T > static T apply( T x, T y ) { return static_cast<T>( x / y ); }
+    template< typename V > static V vapply( V x, V y ) { return vdiv( x, y ); }
+
+    // integer division by zero and the overflowing min / -1 are undefined:
+
+    template< typename T > static bool defined( T x, T y )
+    {
+        typedef std::numeric_limits<T> limits;
+        return ! limits::is_integer
+            || ( y != T() && ! ( limits::is_signed && x == (limits::min)() && y == T(-1) ) );
+    }
+};
+
+struct op_min
+{
+    template< typename T > static T apply( T x, T y ) { return x < y ? x : y; }
+    template< typename T > static bool defined( T, T ) { return true; }
+    template< typename V > static V vapply( V x, V y ) { return vmin( x, y ); }
+};
+
+struct op_max
+{
+    template< typename T > static T apply( T x, T y ) { return y < x ? x : y; }
+    template< typename T > static bool defined( T, T ) { return true; }
+    template< typename V > static V vapply( V x, V y ) { return vmax( x, y ); }
+};
+
+struct op_equal_to
+{
+    template< typename T > static bool apply( T x, T y ) { return x == y; }
+    template< typename V > static V vapply( V x, V y ) { return vcmpeq( x, y ); }
+};
+
+struct op_not_equal_to
+{
+    template< typename T > static bool apply( T x, T y ) { return x != y; }
+    template< typename V > static V vapply( V x, V y ) { return vcmpne( x, y ); }
+};
+
+struct op_less
+{
+    template< typename T > static bool apply( T x, T y ) { return x < y; }
+    template< typename V > static V vapply( V x, V y ) { return vcmplt( x, y ); }
+};
+
+struct op_less_equal
+{
+    template< typename T > static bool apply( T x, T y ) { return x <= y; }
+    template< typename V > static V vapply( V x, V y ) { return vcmple( x, y ); }
+};
+
+struct op_greater
+{
+    template< typename T > static bool apply( T x, T y ) { return x > y; }
+    template< typename V > static V vapply( V x, V y ) { return vcmpgt( x, y ); }
+};
+
+struct op_greater_equal
+{
+    template< typename T > static bool apply( T x, T y ) { return x >= y; }
+    template< typename V > static V vapply( V x, V y ) { return vcmpge( x, y ); }
+};
+
+// engaged bits of bitmap byte j of a column of n elements:
+
+inline unsigned int valid_bits( unsigned char const * a, unsigned char const * b, std::size_t j, std::size_t n )
+{
+    std::size_t const k = n - 8 * j;
+    return ( a[j] & b[j] ) & ( k >= 8 ? 0xffu : ( 1u << k ) - 1 );
+}
+
+// scalar column kernels for elements [first, n), first a multiple of 8; the operands of
+// a disengaged element are replaced by one, so that the operation is always defined:
+
+template< typename Op, typename T >
+T * binary_scalar( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap,
+                   std::size_t first, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    for ( std::size_t j = first / 8; 8 * j < n; ++j )
+    {
+        unsigned int const valid = valid_bits( a_bitmap, b_bitmap, j, n );
+        unsigned int bits = 0;
+        for ( std::size_t i = 8 * j; i < n && i < 8 * j + 8; ++i )
+        {
+            T const x = a[i];
+            T const y = b[i];
+            bool const on = ( ( valid >> ( i % 8 ) ) & 1u ) && Op::defined( x, y );
+            T const r = Op::apply( on ? x : T(1), on ? y : T(1) );
+            out[i] = on ? r : T();
+            bits |= static_cast<unsigned int>( on ) << ( i % 8 );
+        }
+        out_bitmap[j] = static_cast<unsigned char>( bits );
+    }
+    return out + n;
+}
+
+template< typename Op, typename T >
+void compare_scalar( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap,
+                     std::size_t first, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    for ( std::size_t j = first / 8; 8 * j < n; ++j )
+    {
+        unsigned int const valid = valid_bits( a_bitmap, b_bitmap, j, n );
+        unsigned int bits = 0;
+        for ( std::size_t i = 8 * j; i < n && i < 8 * j + 8; ++i )
+        {
+            bits |= static_cast<unsigned int>( Op::apply( a[i], b[i] ) ) << ( i % 8 );
+        }
+        out[j]        = static_cast<unsigned char>( bits & valid );
+        out_bitmap[j] = static_cast<unsigned char>( valid );
+    }
+}
+
+// column kernels, generic:
+
+template< typename Op, typename T >
+T * binary_column( Op, T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap,
+                   std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return binary_scalar<Op>( a, a_bitmap, b, b_bitmap, 0, n, out, out_bitmap );
+}
+
+template< typename Op, typename T >
+void compare_column( Op, T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap,
+                     std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    compare_scalar<Op>( a, a_bitmap, b, b_bitmap, 0, n, out, out_bitmap );
+}
+
+#if optional_HAVE_AVX2 || optional_HAVE_SSE2
+
+// vectorized column kernels, eight elements per bitmap byte:
+
+template< typename Op, typename T >
+T * binary_simd( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap,
+                 std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    typedef simd<T> V;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = static_cast<unsigned char>( a_bitmap[ i / 8 ] & b_bitmap[ i / 8 ] );
+        for ( int part = 0; part * V::lanes < 8; ++part )
+        {
+            std::size_t const k = i + static_cast<std::size_t>( part * V::lanes );
+            V::store( out + k, V::zero_unless( V::mask( byte, part ), Op::vapply( V::load( a + k ), V::load( b + k ) ) ) );
+        }
+        out_bitmap[ i / 8 ] = byte;
+    }
+    return binary_scalar<Op>( a, a_bitmap, b, b_bitmap, i, n, out, out_bitmap );
+}
+
+template< typename Op, typename T >
+void compare_simd( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap,
+                   std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    typedef simd<T> V;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned int const byte = a_bitmap[ i / 8 ] & b_bitmap[ i / 8 ];
+        unsigned int bits = 0;
+        for ( int part = 0; part * V::lanes < 8; ++part )
+        {
+            std::size_t const k = i + static_cast<std::size_t>( part * V::lanes );
+            bits |= V::bits( Op::vapply( V::load( a + k ), V::load( b + k ) ) ) << ( part * V::lanes );
+        }
+        out[ i / 8 ]        = static_cast<unsigned char>( bits & byte );
+        out_bitmap[ i / 8 ] = static_cast<unsigned char>( byte );
+    }
+    compare_scalar<Op>( a, a_bitmap, b, b_bitmap, i, n, out, out_bitmap );
+}
+
+// column kernels for double and int; there is no vectorized integer division:
+
+template< typename Op >
+double * binary_column( Op, double const * a, unsigned char const * a_bitmap, double const * b, unsigned char const * b_bitmap,
+                        std::size_t n, double * out, unsigned char * out_bitmap )
+{
+    return binary_simd<Op>( a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename Op >
+int * binary_column( Op, int const * a, unsigned char const * a_bitmap, int const * b, unsigned char const * b_bitmap,
+                     std::size_t n, int * out, unsigned char * out_bitmap )
+{
+    return binary_simd<Op>( a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+inline int * binary_column( op_div, int const * a, unsigned char const * a_bitmap, int const * b, unsigned char const * b_bitmap,
+                            std::size_t n, int * out, unsigned char * out_bitmap )
+{
+    return binary_scalar<op_div>( a, a_bitmap, b, b_bitmap, 0, n, out, out_bitmap );
+}
+
+template< typename Op >
+void compare_column( Op, double const * a, unsigned char const * a_bitmap, double const * b, unsigned char const * b_bitmap,
+                     std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    compare_simd<Op>( a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename Op >
+void compare_column( Op, int const * a, unsigned char const * a_bitmap, int const * b, unsigned char const * b_bitmap,
+                     std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    compare_simd<Op>( a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+#endif // optional_HAVE_AVX2 || optional_HAVE_SSE2
+
+// operation on ranges of optional<T>:
+
+template< typename Op, typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt binary_range( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out )
+{
+    typedef typename optional_value_type<InputIt1>::type T;
+
+    for ( ; first1 != last1; ++first1, ++first2, ++out )
+    {
+        T const x = value_or_zero( *first1 );
+        T const y = value_or_zero( *first2 );
+        bool const on = ( (*first1).has_value() & (*first2).has_value() ) && Op::defined( x, y );
+        T const r = Op::apply( on ? x : T(1), on ? y : T(1) );
+        *out = on ? optional<T>( r ) : optional<T>();
+    }
+    return out;
+}
+
+template< typename Op, typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt compare_range( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out )
+{
+    for ( ; first1 != last1; ++first1, ++first2, ++out )
+    {
+        bool const on = (*first1).has_value() & (*first2).has_value();
+        bool const r = Op::apply( value_or_zero( *first1 ), value_or_zero( *first2 ) );
+        *out = on ? optional<bool>( r ) : optional<bool>();
+    }
+    return out;
+}
+
+// operation on optional_vectors of equal size:
+
+template< typename Op, typename T >
+optional_vector<T> binary_vector( optional_vector<T> const & a, optional_vector<T> const & b )
+{
+    assert( a.size() == b.size() );
+
+    optional_vector<T> r( a.size() );
+    binary_column( Op(), a.values(), a.bitmap(), b.values(), b.bitmap(), a.size(),
+        optional_bare::detail::column_access::values( r ), optional_bare::detail::column_access::bitmap( r ) );
+    return r;
+}
+
+} // namespace detail
+
+// element-wise arithmetic of columns of n values: out and out_bitmap receive
+// n values and ( n + 7 ) / 8 bytes; return the end of out:
+
+template< typename T >
+T * add( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return detail::binary_column( detail::op_add(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+T * sub( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return detail::binary_column( detail::op_sub(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+T * mul( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return detail::binary_column( detail::op_mul(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+T * div( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return detail::binary_column( detail::op_div(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+T * min( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return detail::binary_column( detail::op_min(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+T * max( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, T * out, unsigned char * out_bitmap )
+{
+    return detail::binary_column( detail::op_max(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+// element-wise comparison of columns of n values: the results are written
+// as a bitmap to out, their validity to out_bitmap, ( n + 7 ) / 8 bytes each:
+
+template< typename T >
+void equal_to( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    detail::compare_column( detail::op_equal_to(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+void not_equal_to( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    detail::compare_column( detail::op_not_equal_to(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+void less( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    detail::compare_column( detail::op_less(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+void less_equal( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    detail::compare_column( detail::op_less_equal(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+void greater( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    detail::compare_column( detail::op_greater(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+template< typename T >
+void greater_equal( T const * a, unsigned char const * a_bitmap, T const * b, unsigned char const * b_bitmap, std::size_t n, unsigned char * out, unsigned char * out_bitmap )
+{
+    detail::compare_column( detail::op_greater_equal(), a, a_bitmap, b, b_bitmap, n, out, out_bitmap );
+}
+
+// element-wise arithmetic of optional_vectors of equal size:
+
+template< typename T > optional_vector<T> add( optional_vector<T> const & a, optional_vector<T> const & b ) { return detail::binary_vector< detail::op_add >( a, b ); }
+template< typename T > optional_vector<T> sub( optional_vector<T> const & a, optional_vector<T> const & b ) { return detail::binary_vector< detail::op_sub >( a, b ); }
+template< typename T > optional_vector<T> mul( optional_vector<T> const & a, optional_vector<T> const & b ) { return detail::binary_vector< detail::op_mul >( a, b ); }
+template< typename T > optional_vector<T> div( optional_vector<T> const & a, optional_vector<T> const & b ) { return detail::binary_vector< detail::op_div >( a, b ); }
+template< typename T > optional_vector<T> min( optional_vector<T> const & a, optional_vector<T> const & b ) { return detail::binary_vector< detail::op_min >( a, b ); }
+template< typename T > optional_vector<T> max( optional_vector<T> const & a, optional_vector<T> const & b ) { return detail::binary_vector< detail::op_max >( a, b ); }
+
+// element-wise operations on ranges of optional<T>, writing optional<T>,
+// respectively optional<bool>, to out:
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt add( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::binary_range< detail::op_add >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt sub( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::binary_range< detail::op_sub >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt mul( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::binary_range< detail::op_mul >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt div( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::binary_range< detail::op_div >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt min( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::binary_range< detail::op_min >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt max( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::binary_range< detail::op_max >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt equal_to( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::compare_range< detail::op_equal_to >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt not_equal_to( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::compare_range< detail::op_not_equal_to >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt less( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::compare_range< detail::op_less >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt less_equal( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::compare_range< detail::op_less_equal >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt greater( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::compare_range< detail::op_greater >( first1, last1, first2, out ); }
+
+template< typename InputIt1, typename InputIt2, typename OutputIt >
+OutputIt greater_equal( InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt out ) { return detail::compare_range< detail::op_greater_equal >( first1, last1, first2, out ); }
+
+//
+// Replacement of disengaged elements by a default value, or by the
+// corresponding element of an array of defaults:
+//
+
+namespace detail {
+
+// sources of defaults:
+
+template< typename T >
+struct fill_value
+{
+    T value;
+
+    explicit fill_value( T const & v ) : value( v ) {}
+
+    T operator[]( std::size_t ) const { return value; }
+
+#if optional_HAVE_AVX2 || optional_HAVE_SSE2
+    typename simd<T>::type load( std::size_t ) const { return simd<T>::broadcast( value ); }
+#endif
+};
+
+template< typename T >
+struct fill_array
+{
+    T const * values;
+
+    explicit fill_array( T const * p ) : values( p ) {}
+
+    T operator[]( std::size_t i ) const { return values[i]; }
+
+#if optional_HAVE_AVX2 || optional_HAVE_SSE2
+    typename simd<T>::type load( std::size_t i ) const { return simd<T>::load( values + i ); }
+#endif
+};
+
+// scalar column kernel for elements [first, n):
+
+template< typename T, typename Source >
+T * fill_scalar( T const * values, unsigned char const * bitmap, std::size_t first, std::size_t n, Source const & source, T * out )
+{
+    for ( std::size_t i = first; i < n; ++i )
+    {
+        T const v = values[i];
+        T const d = source[i];
+        out[i] = test( bitmap, i ) ? v : d;
+    }
+    return out + n;
+}
+
+// column kernels, generic:
+
+template< typename T, template< typename > class Source >
+T * fill_column( T const * values, unsigned char const * bitmap, std::size_t n, Source<T> const & source, T * out )
+{
+    return fill_scalar( values, bitmap, 0, n, source, out );
+}
+
+#if optional_HAVE_AVX2 || optional_HAVE_SSE2
+
+// column kernels for double and int, eight elements per bitmap byte:
+
+template< typename T, typename Source >
+T * fill_simd( T const * values, unsigned char const * bitmap, std::size_t n, Source const & source, T * out )
+{
+    typedef simd<T> V;
+
+    std::size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 )
+    {
+        unsigned char const byte = bitmap[ i / 8 ];
+        for ( int part = 0; part * V::lanes < 8; ++part )
+        {
+            std::size_t const k = i + static_cast<std::size_t>( part * V::lanes );
+            V::store( out + k, V::select( V::mask( byte, part ), V::load( values + k ), source.load( k ) ) );
+        }
+    }
+    return fill_scalar( values, bitmap, i, n, source, out );
+}
+
+template< template< typename > class Source >
+double * fill_column( double const * values, unsigned char const * bitmap, std::size_t n, Source<double> const & source, double * out )
+{
+    return fill_simd( values, bitmap, n, source, out );
+}
+
+template< template< typename > class Source >
+int * fill_column( int const * values, unsigned char const * bitmap, std::size_t n, Source<int> const & source, int * out )
+{
+    return fill_simd( values, bitmap, n, source, out );
+}
+
+#endif // optional_HAVE_AVX2 || optional_HAVE_SSE2
+
+// T in a non-deduced context:
+
+template< typename T >
+struct identity { typedef T type; };
+
+// type R for an iterator type, to remove an overload for other types:
+
+template< typename It, typename R, typename = void >
+struct if_iterator {};
+
+template< typename T, typename R >
+struct if_iterator< T *, R > { typedef R type; };
+
+template< typename It, typename R >
+struct if_iterator< It, R, typename void_type< typename It::iterator_category >::type > { typedef R type; };
+
+} // namespace detail
+
+// write the n values of a column to out, with value, respectively defaults[i],
+// for a disengaged element i; out may be values; return the end of out:
+
+template< typename T >
+T * fill_missing( T const * values, unsigned char const * bitmap, std::size_t n, typename detail::identity<T>::type const & value, T * out )
+{
+    return detail::fill_column( values, bitmap, n, detail::fill_value<T>( value ), out );
+}
+
+template< typename T >
+T * fill_missing( T const * values, unsigned char const * bitmap, std::size_t n, T const * defaults, T * out )
+{
+    return detail::fill_column( values, bitmap, n, detail::fill_array<T>( defaults ), out );
+}
+
+template< typename T >
+T * fill_missing( optional_vector<T> const & v, typename detail::identity<T>::type const & value, T * out )
+{
+    return fill_missing( v.values(), v.bitmap(), v.size(), value, out );
+}
+
+template< typename T >
+T * fill_missing( optional_vector<T> const & v, T const * defaults, T * out )
+{
+    return fill_missing( v.values(), v.bitmap(), v.size(), defaults, out );
+}
+
+// write the values of a range of optional<T> to out, with value, respectively
+// the corresponding element of the range starting at defaults, for a disengaged
+// element:
+
+template< typename InputIt, typename OutputIt >
+OutputIt fill_missing( InputIt first, InputIt last, typename detail::optional_value_type<InputIt>::type const & value, OutputIt out )
+{
+    typedef typename detail::optional_value_type<InputIt>::type T;
+
+    for ( ; first != last; ++first, ++out )
+    {
+        T const v = detail::value_or_zero( *first );
+        *out = (*first).has_value() ? v : value;
+    }
+    return out;
+}
+
+template< typename InputIt, typename DefaultIt, typename OutputIt >
+typename detail::if_iterator< DefaultIt, OutputIt >::type
+fill_missing( InputIt first, InputIt last, DefaultIt defaults, OutputIt out )
+{
+    typedef typename detail::optional_value_type<InputIt>::type T;
+
+    for ( ; first != last; ++first, ++defaults, ++out )
+    {
+        T const v = detail::value_or_zero( *first );
+        T const d = *defaults;
+        *out = (*first).has_value() ? v : d;
+    }
+    return out;
+}
+
+//
+// Propagation of the last engaged value forward (ffill), respectively of the
+// next engaged value backward (bfill), into the disengaged elements that follow,
+// respectively precede, it. With a limit, at most that many consecutive
+// disengaged elements of a gap are filled; elements without a value to
+// propagate stay disengaged.
+//
+
+namespace detail {
+
+// no limit on the number of filled elements of a gap:
+
+inline std::size_t no_limit()
+{
+    return (std::numeric_limits<std::size_t>::max)();
+}
+
+// the value carried into a gap and the length of the gap so far:
+
+template< typename T >
+struct carry
+{
+    T value;
+    bool has;
+    std::size_t gap;
+    std::size_t limit;
+
+    explicit carry( std::size_t lim )
+    : value(), has( false ), gap( 0 ), limit( lim )
+    {}
+
+    // next element with value v, engaged if on: write its filled value to out
+    // and return whether it is engaged, with selections rather than branches:
+
+    bool step( T const & v, bool on, T & out )
+    {
+        value = on ? v : value;
+        has   = has || on;
+        gap   = on ? 0 : gap + 1;
+
+        bool const filled = has & ( gap <= limit );
+        out = filled ? value : T();
+        return filled;
+    }
+
+    // engaged element with value v, followed by gap disengaged elements:
+
+    void take( T const & v, std::size_t g )
+    {
+        value = v;
+        has   = true;
+        gap   = g;
+    }
+
+    // next count disengaged elements: return how many of them are filled:
+
+    std::size_t skip( std::size_t count )
+    {
+        std::size_t const room = has && limit > gap ? limit - gap : 0;
+        gap += count;
+        return room < count ? room : count;
+    }
+};
+
+// the low, respectively high, m bits of a block of count bits, m <= count <= 64:
+
+inline unsigned long long low_bits( std::size_t m )
+{
+    return m < 64 ? ( 1ull << m ) - 1 : ~0ull;
+}
+
+inline unsigned long long high_bits( std::size_t m, std::size_t count )
+{
+    return m > 0 ? low_bits( m ) << ( count - m ) : 0;
+}
+
+// number of leading zero bits of a non-zero 64-bit word:
+
+inline std::size_t countl_zero( unsigned long long w )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return static_cast<std::size_t>( __builtin_clzll( w ) );
+#else
+    std::size_t n = 0;
+    for ( ; ! ( w >> 63 ); w <<= 1 )
+        ++n;
+    return n;
+#endif
+}
+
+// count bits of a bitmap, 0 < count <= 64, reading only the bytes that hold them:
+
+inline unsigned long long load_bits( unsigned char const * bitmap, std::size_t count )
+{
+    unsigned long long w = 0;
+    for ( std::size_t k = 0; k * 8 < count; ++k )
+        w |= static_cast<unsigned long long>( bitmap[k] ) << ( 8 * k );
+    return w & low_bits( count );
+}
+
+inline void store_bits( unsigned char * bitmap, unsigned long long w, std::size_t count )
+{
+    for ( std::size_t k = 0; k * 8 < count; ++k )
+        bitmap[k] = static_cast<unsigned char>( w >> ( 8 * k ) );
+}
+
+// value-initialize the elements of a block at the set bits of holes:
+
+template< typename T >
+void clear( T * out, unsigned long long holes )
+{
+    for ( ; holes != 0; holes &= holes - 1 )
+        out[ countr_zero( holes ) ] = T();
+}
+
+// column kernels in blocks of 64 elements, a word of the bitmap. A block without
+// disengaged elements is copied. The gap that continues from the previous block
+// is filled from the carried value as a whole. The rest of the block is copied
+// and then each hole, a disengaged element, is copied from the last engaged
+// element before it, at a distance obtained from the bitmap word by a leading
+// zero count, so that the holes do not depend on one another; the holes beyond
+// the limit are value-initialized afterwards.
+
+template< typename T >
+T * ffill_column( T const * values, unsigned char const * bitmap, std::size_t n, T * out, unsigned char * out_bitmap, std::size_t limit )
+{
+    carry<T> c( limit );
+
+    for ( std::size_t i = 0; i < n; i += 64 )
+    {
+        std::size_t const count = n - i < 64 ? n - i : 64;
+        unsigned long long const all = low_bits( count );
+        unsigned long long const w = load_bits( bitmap + i / 8, count );
+
+        if ( w == all )
+        {
+            if ( out != values )
+                std::copy( values + i, values + i + count, out + i );
+            c.take( values[ i + count - 1 ], 0 );
+            store_bits( out_bitmap + i / 8, all, count );
+            continue;
+        }
+
+        std::size_t const lead = w == 0 ? count : countr_zero( w );
+        std::size_t const filled = c.skip( lead );
+        std::fill( out + i, out + i + filled, c.value );
+        std::fill( out + i + filled, out + i + lead, T() );
+        unsigned long long bits = low_bits( filled );
+
+        if ( lead < count )
+        {
+            if ( out != values )
+                std::copy( values + i + lead, values + i + count, out + i + lead );
+
+            unsigned long long const holes = all & ~w & ~low_bits( lead );
+            unsigned long long kept = 0;
+            for ( unsigned long long h = holes; h != 0; h &= h - 1 )
+            {
+                std::size_t const k = countr_zero( h );
+                std::size_t const gap = countl_zero( w << ( 63 - k ) );
+                out[ i + k ] = values[ i + k - gap ];
+                kept |= static_cast<unsigned long long>( gap <= limit ) << k;
+            }
+            bits |= w | kept;
+            clear( out + i, holes & ~kept );
+
+            std::size_t const gap = countl_zero( w << ( 64 - count ) );
+            c.take( values[ i + count - 1 - gap ], gap );
+        }
+        store_bits( out_bitmap + i / 8, bits, count );
+    }
+    return out + n;
+}
+
+template< typename T >
+T * bfill_column( T const * values, unsigned char const * bitmap, std::size_t n, T * out, unsigned char * out_bitmap, std::size_t limit )
+{
+    carry<T> c( limit );
+
+    for ( std::size_t end = n, i = 0; end > 0; end = i )
+    {
+        i = ( end - 1 ) / 64 * 64;
+
+        std::size_t const count = end - i;
+        unsigned long long const all = low_bits( count );
+        unsigned long long const w = load_bits( bitmap + i / 8, count );
+
+        if ( w == all )
+        {
+            if ( out != values )
+                std::copy( values + i, values + end, out + i );
+            c.take( values[ i ], 0 );
+            store_bits( out_bitmap + i / 8, all, count );
+            continue;
+        }
+
+        std::size_t const trail = w == 0 ? count : countl_zero( w ) - ( 64 - count );
+        std::size_t const filled = c.skip( trail );
+        std::fill( out + end - trail, out + end - filled, T() );
+        std::fill( out + end - filled, out + end, c.value );
+        unsigned long long bits = high_bits( filled, count );
+
+        if ( trail < count )
+        {
+            if ( out != values )
+                std::copy( values + i, values + end - trail, out + i );
+
+            unsigned long long const holes = all & ~w & ~high_bits( trail, count );
+            unsigned long long kept = 0;
+            for ( unsigned long long h = holes; h != 0; h &= h - 1 )
+            {
+                std::size_t const k = countr_zero( h );
+                std::size_t const gap = countr_zero( w >> k );
+                out[ i + k ] = values[ i + k + gap ];
+                kept |= static_cast<unsigned long long>( gap <= limit ) << k;
+            }
+            bits |= w | kept;
+            clear( out + i, holes & ~kept );
+
+            std::size_t const gap = countr_zero( w );
+            c.take( values[ i + gap ], gap );
+        }
+        store_bits( out_bitmap + i / 8, bits, count );
+    }
+    return out + n;
+}
+
+// filled optional_vector:
+
+template< typename T >
+optional_vector<T> fill_vector( T * ( *kernel )( T const *, unsigned char const *, std::size_t, T *, unsigned char *, std::size_t ), optional_vector<T> const & v, std::size_t limit )
+{
+    optional_vector<T> r( v.size() );
+    kernel( v.values(), v.bitmap(), v.size(),
+        optional_bare::detail::column_access::values( r ), optional_bare::detail::column_access::bitmap( r ), limit );
+    return r;
+}
+
+} // namespace detail
+
+// fill the disengaged elements of a column of n values with the last, respectively
+// the next, engaged value, at most limit consecutive elements of a gap; out and
+// out_bitmap receive n values and ( n + 7 ) / 8 bytes and may be values and
+// bitmap; return the end of out:
+
+template< typename T >
+T * ffill( T const * values, unsigned char const * bitmap, std::size_t n, T * out, unsigned char * out_bitmap, std::size_t limit = detail::no_limit() )
+{
+    return detail::ffill_column( values, bitmap, n, out, out_bitmap, limit );
+}
+
+template< typename T >
+T * bfill( T const * values, unsigned char const * bitmap, std::size_t n, T * out, unsigned char * out_bitmap, std::size_t limit = detail::no_limit() )
+{
+    return detail::bfill_column( values, bitmap, n, out, out_bitmap, limit );
+}
+
+template< typename T >
+optional_vector<T> ffill( optional_vector<T> const & v, std::size_t limit = detail::no_limit() )
+{
+    return detail::fill_vector( &detail::ffill_column<T>, v, limit );
+}
+
+template< typename T >
+optional_vector<T> bfill( optional_vector<T> const & v, std::size_t limit = detail::no_limit() )
+{
+    return detail::fill_vector( &detail::bfill_column<T>, v, limit );
+}
+
+// fill a range of optional<T> into out, which may be first; bfill writes
+// backward from the end of out and requires bidirectional iterators:
+
+template< typename InputIt, typename OutputIt >
+OutputIt ffill( InputIt first, InputIt last, OutputIt out, std::size_t limit = detail::no_limit() )
+{
+    typedef typename detail::optional_value_type<InputIt>::type T;
+
+    detail::carry<T> c( limit );
+
+    for ( ; first != last; ++first, ++out )
+    {
+        T v;
+        bool const on = c.step( detail::value_or_zero( *first ), (*first).has_value(), v );
+        *out = on ? optional<T>( v ) : optional<T>();
+    }
+    return out;
+}
+
+template< typename BidirIt1, typename BidirIt2 >
+BidirIt2 bfill( BidirIt1 first, BidirIt1 last, BidirIt2 out, std::size_t limit = detail::no_limit() )
+{
+    typedef typename detail::optional_value_type<BidirIt1>::type T;
+
+    detail::carry<T> c( limit );
+
+    std::advance( out, std::distance( first, last ) );
+
+    for ( BidirIt2 pos = out; last != first; )
+    {
+        --last; --pos;
+
+        T v;
+        bool const on = c.step( detail::value_or_zero( *last ), (*last).has_value(), v );
+        *pos = on ? optional<T>( v ) : optional<T>();
+    }
+    return out;
+}
+
+//
+// Sorting of a sequence of optionals with the disengaged elements first or
+// last: the engaged values are gathered into a dense sequence in one pass and
+// sorted there, by a radix sort for integer and IEEE floating-point types in
+// ascending or descending order and by std::sort otherwise.
+//
+
+enum null_order { nulls_first, nulls_last };
+
+namespace detail {
+
+// unsigned integer type of a size:
+
+template< std::size_t Size > struct unsigned_of { enum { value = false }; };
+template<> struct unsigned_of<1> { enum { value = true }; typedef unsigned char      type; };
+template<> struct unsigned_of<2> { enum { value = true }; typedef unsigned short     type; };
+template<> struct unsigned_of<4> { enum { value = true }; typedef unsigned int       type; };
+template<> struct unsigned_of<8> { enum { value = true }; typedef unsigned long long type; };
+
+// whether T maps to an unsigned key of the same size with the same order:
+
+template< typename T >
+struct radix_sortable
+{
+    enum { value = unsigned_of< sizeof( T ) >::value
+        && ( std::numeric_limits<T>::is_integer || ( std::numeric_limits<T>::is_iec559 && sizeof( T ) >= 4 ) ) };
+};
+
+// direction of a comparison: 1 for std::less, -1 for std::greater, 0 otherwise:
+
+template< typename Compare, typename T > struct radix_direction { enum { value = 0 }; };
+template< typename T > struct radix_direction< std::less<T>   , T > { enum { value =  1 }; };
+template< typename T > struct radix_direction< std::greater<T>, T > { enum { value = -1 }; };
+
+template< bool B > struct bool_tag {};
+
+// key of a value: the sign bit of a signed integer is flipped, as is the sign bit
+// of a non-negative floating-point value and all bits of a negative one:
+
+template< typename U, typename T >
+U to_key( T const & v )
+{
+    U const sign = static_cast<U>( U( 1 ) << ( 8 * sizeof( U ) - 1 ) );
+
+    U u;
+    std::memcpy( &u, &v, sizeof u );
+
+    if ( std::numeric_limits<T>::is_integer )
+        return std::numeric_limits<T>::is_signed ? static_cast<U>( u ^ sign ) : u;
+
+    U const negative = static_cast<U>( u >> ( 8 * sizeof( U ) - 1 ) );
+    return static_cast<U>( u ^ ( static_cast<U>( 0 - negative ) | sign ) );
+}
+
+template< typename T, typename U >
+T from_key( U u )
+{
+    U const sign = static_cast<U>( U( 1 ) << ( 8 * sizeof( U ) - 1 ) );
+
+    if ( std::numeric_limits<T>::is_integer )
+        u = std::numeric_limits<T>::is_signed ? static_cast<U>( u ^ sign ) : u;
+    else
+        u = static_cast<U>( u ^ ( static_cast<U>( ( u >> ( 8 * sizeof( U ) - 1 ) ) - 1 ) | sign ) );
+
+    T v;
+    std::memcpy( &v, &u, sizeof v );
+    return v;
+}
+
+// least significant digit radix sort of n keys in digits of 11 bits, so that
+// the counts of a digit fit the L1 cache; the counts of all digits are gathered
+// in one pass and a digit that is equal in all keys is skipped:
+
+template< typename U >
+void radix_sort( U * keys, U * scratch, std::size_t n )
+{
+    std::size_t const bits    = 11;
+    std::size_t const radix   = std::size_t( 1 ) << bits;
+    std::size_t const digits  = ( 8 * sizeof( U ) + bits - 1 ) / bits;
+    U           const mask    = static_cast<U>( radix - 1 );
+
+    std::vector< std::size_t > counts( digits * radix );
+
+    for ( std::size_t i = 0; i < n; ++i )
+        for ( std::size_t d = 0; d < digits; ++d )
+            ++counts[ d * radix + ( ( keys[i] >> ( bits * d ) ) & mask ) ];
+
+    U * src = keys;
+    U * dst = scratch;
+
+    for ( std::size_t d = 0; d < digits; ++d )
+    {
+        std::size_t * const c = &counts[ d * radix ];
+
+        if ( c[ ( src[0] >> ( bits * d ) ) & mask ] == n )
+            continue;
+
+        for ( std::size_t b = 0, sum = 0; b < radix; ++b )
+        {
+            std::size_t const t = c[b];
+            c[b] = sum;
+            sum += t;
+        }
+
+        for ( std::size_t i = 0; i < n; ++i )
+            dst[ c[ ( src[i] >> ( bits * d ) ) & mask ]++ ] = src[i];
+
+        std::swap( src, dst );
+    }
+
+    if ( src != keys )
+        std::copy( src, src + n, keys );
+}
+
+// comparison of floating-point values by their radix keys, which orders NaNs
+// and -0.0 and +0.0 as the radix sort does, unlike std::less:
+
+template< typename T, typename U >
+struct key_compare
+{
+    U invert;
+
+    explicit key_compare( U inv ) : invert( inv ) {}
+
+    bool operator()( T const & x, T const & y ) const
+    {
+        return static_cast<U>( to_key<U>( x ) ^ invert ) < static_cast<U>( to_key<U>( y ) ^ invert );
+    }
+};
+
+// sort dense values; below radix_threshold values, std::sort is faster:
+
+std::size_t const radix_threshold = 2048;
+
+template< typename T, typename Compare >
+void sort_dense( T * first, T * last, Compare comp, bool_tag<false> )
+{
+    std::sort( first, last, comp );
+}
+
+template< typename T, typename Compare >
+void sort_dense( T * first, T * last, Compare comp, bool_tag<true> )
+{
+    typedef typename unsigned_of< sizeof( T ) >::type U;
+
+    std::size_t const n = static_cast<std::size_t>( last - first );
+    U const invert = radix_direction<Compare, T>::value < 0 ? static_cast<U>( ~U( 0 ) ) : U( 0 );
+
+    if ( n < radix_threshold )
+    {
+        if ( std::numeric_limits<T>::is_integer )
+            std::sort( first, last, comp );
+        else
+            std::sort( first, last, key_compare<T, U>( invert ) );
+        return;
+    }
+
+    std::vector<U> keys( 2 * n );
+    for ( std::size_t i = 0; i < n; ++i )
+        keys[i] = static_cast<U>( to_key<U>( first[i] ) ^ invert );
+
+    radix_sort( &keys[0], &keys[n], n );
+
+    for ( std::size_t i = 0; i < n; ++i )
+        first[i] = from_key<T>( static_cast<U>( keys[i] ^ invert ) );
+}
+
+template< typename T, typename Compare >
+void sort_dense( T * first, T * last, Compare comp )
+{
+    sort_dense( first, last, comp, bool_tag< radix_sortable<T>::value && radix_direction<Compare, T>::value != 0 >() );
+}
+
+// gather the engaged values of an optional_vector into dense, with the vectorized
+// compact() for an arithmetic T, and by moving the values otherwise:
+
+template< typename T >
+void gather_dense( optional_vector<T> & v, std::vector<T> & dense, bool_tag<true> )
+{
+    compact( v, &dense[0] );
+}
+
+template< typename T >
+void gather_dense( optional_vector<T> & v, std::vector<T> & dense, bool_tag<false> )
+{
+    T * const values = optional_bare::detail::column_access::values( v );
+
+    for ( std::size_t i = 0, k = 0; i < v.size(); ++i )
+    {
+        if ( test( v.bitmap(), i ) )
+#if optional_CPP11_OR_GREATER
+            dense[ k++ ] = std::move( values[i] );
+#else
+            dense[ k++ ] = values[i];
+#endif
+    }
+}
+
+} // namespace detail
+
+// sort a range of optional<T> with the disengaged elements first or last and
+// the engaged values ordered by comp, by default by std::less<T>; comp must be a
+// strict weak ordering of the engaged values, which std::less<double> is not for
+// NaNs, except that with std::less and std::greater of float and double, the
+// values are ordered as by their bits: negative NaNs before -inf, -0.0 before
+// +0.0 and positive NaNs after +inf; the values are moved with C++11:
+
+template< typename ForwardIt, typename Compare >
+void sort_optional( ForwardIt first, ForwardIt last, null_order order, Compare comp )
+{
+    typedef typename detail::optional_value_type<ForwardIt>::type T;
+
+    std::vector<T> dense;
+    dense.reserve( static_cast<std::size_t>( std::distance( first, last ) ) );
+
+    for ( ForwardIt pos = first; pos != last; ++pos )
+    {
+        if ( (*pos).has_value() )
+#if optional_CPP11_OR_GREATER
+            dense.push_back( std::move( **pos ) );
+#else
+            dense.push_back( **pos );
+#endif
+    }
+
+    if ( dense.empty() )
+        return;
+
+    detail::sort_dense( &dense[0], &dense[0] + dense.size(), comp );
+
+    std::size_t const nulls = static_cast<std::size_t>( std::distance( first, last ) ) - dense.size();
+
+    if ( order == nulls_first )
+        for ( std::size_t i = 0; i < nulls; ++i, ++first )
+            *first = optional<T>();
+
+    for ( std::size_t i = 0; i < dense.size(); ++i, ++first )
+#if optional_CPP11_OR_GREATER
+        *first = optional<T>( std::move( dense[i] ) );
+#else
+        *first = optional<T>( dense[i] );
+#endif
+
+    for ( ; first != last; ++first )
+        *first = optional<T>();
+}
+
+template< typename ForwardIt >
+void sort_optional( ForwardIt first, ForwardIt last, null_order order = nulls_first )
+{
+    sort_optional( first, last, order, std::less< typename detail::optional_value_type<ForwardIt>::type >() );
+}
+
+// sort an optional_vector with the disengaged elements first or last:
+
+template< typename T, typename Compare >
+void sort_optional( optional_vector<T> & v, null_order order, Compare comp )
+{
+    std::size_t const n = v.size();
+    std::size_t const engaged = count( v );
+
+    if ( engaged == 0 )
+        return;
+
+    std::vector<T> dense( engaged );
+    detail::gather_dense( v, dense, detail::bool_tag< std::numeric_limits<T>::is_specialized >() );
+    detail::sort_dense( &dense[0], &dense[0] + engaged, comp );
+
+    T * const values = optional_bare::detail::column_access::values( v );
+    unsigned char * const bitmap = optional_bare::detail::column_access::bitmap( v );
+
+    std::size_t const lo = order == nulls_first ? n - engaged : 0;
+    std::size_t const hi = lo + engaged;
+
+    std::fill( values, values + lo, T() );
+#if optional_CPP11_OR_GREATER
+    std::move( dense.begin(), dense.end(), values + lo );
+#else
+    std::copy( dense.begin(), dense.end(), values + lo );
+#endif
+    std::fill( values + hi, values + n, T() );
+
+    for ( std::size_t i = 0; i < n; i += 64 )
+    {
+        std::size_t const count = n - i < 64 ? n - i : 64;
+        std::size_t const a = lo > i ? ( std::min )( lo - i, count ) : 0;
+        std::size_t const b = hi > i ? ( std::min )( hi - i, count ) : 0;
+
+        detail::store_bits( bitmap + i / 8, detail::low_bits( b ) & ~detail::low_bits( a ), count );
+    }
+}
+
+template< typename T >
+void sort_optional( optional_vector<T> & v, null_order order = nulls_first )
+{
+    sort_optional( v, order, std::less<T>() );
+}
+
+} // namespace optional_algorithm
+} // namespace nonstd
+
+#endif // NONSTD_OPTIONAL_ALGORITHM_HPP
@@ -0,0 +1,320 @@
+//
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NONSTD_OPTIONAL_VECTOR_HPP
+#define NONSTD_OPTIONAL_VECTOR_HPP
+
+#include "nonstd/optional.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+#if optional_CPP11_OR_GREATER
+# include <type_traits>
+#endif
+
+namespace nonstd { namespace optional_bare {
+
+namespace detail {
+
+// writable access to the column of an optional_vector, for algorithms that
+// keep its invariants:
+
+struct column_access;
+
+} // namespace detail
+
+// Columnar sequence of optional<T>: the values are stored densely in a std::vector<T>
+// and the engaged state in a packed validity bitmap of one bit per element, least
+// significant bit first. A disengaged element holds a value-initialized T and unused
+// bits of the last bitmap byte are zero.
+// Note: requires T to be default-constructible and copyable, and T not to be bool,
+// as std::vector<bool> does not store its values as an array of bool.
+
+template< typename T >
+class optional_vector
+{
+#if optional_CPP11_OR_GREATER
+    static_assert( ! std::is_same<T, bool>::value, "optional_vector: T must not be bool, use e.g. unsigned char" );
+#endif
+
+public:
+    typedef optional<T>         value_type;
+    typedef std::size_t         size_type;
+    typedef std::ptrdiff_t      difference_type;
+    typedef unsigned char       bitmap_type;
+
+    // iterator that yields optional<T> by value: it provides the operations of a
+    // random access iterator, but as its reference is not a reference, it is an
+    // input iterator to C++98 algorithms, and a random access iterator to C++20's
+    // iterator concepts, which allow a by-value reference:
+
+    class const_iterator
+    {
+    public:
+        typedef std::input_iterator_tag         iterator_category;
+#if optional_CPP20_OR_GREATER
+        typedef std::random_access_iterator_tag iterator_concept;
+#endif
+        typedef optional<T>                     value_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef optional<T>                     reference;
+        typedef void                            pointer;
+
+        const_iterator()
+        : v_( 0 ), i_( 0 )
+        {}
+
+        const_iterator( optional_vector const * v, size_type i )
+        : v_( v ), i_( i )
+        {}
+
+        reference operator*() const { return (*v_)[ i_ ]; }
+        reference operator[]( difference_type n ) const { return (*v_)[ i_ + static_cast<size_type>( n ) ]; }
+
+        const_iterator & operator++() { ++i_; return *this; }
+        const_iterator & operator--() { --i_; return *this; }
+        const_iterator operator++( int ) { const_iterator tmp( *this ); ++i_; return tmp; }
+        const_iterator operator--( int ) { const_iterator tmp( *this ); --i_; return tmp; }
+
+        const_iterator & operator+=( difference_type n ) { i_ += static_cast<size_type>( n ); return *this; }
+        const_iterator & operator-=( difference_type n ) { i_ -= static_cast<size_type>( n ); return *this; }
+
+        friend const_iterator operator+( const_iterator it, difference_type n ) { return it += n; }
+        friend const_iterator operator+( difference_type n, const_iterator it ) { return it += n; }
+        friend const_iterator operator-( const_iterator it, difference_type n ) { return it -= n; }
+
+        friend difference_type operator-( const_iterator const & a, const_iterator const & b )
+        {
+            return static_cast<difference_type>( a.i_ ) - static_cast<difference_type>( b.i_ );
+        }
+
+        friend bool operator==( const_iterator const & a, const_iterator const & b ) { return a.i_ == b.i_; }
+        friend bool operator!=( const_iterator const & a, const_iterator const & b ) { return a.i_ != b.i_; }
+        friend bool operator< ( const_iterator const & a, const_iterator const & b ) { return a.i_ <  b.i_; }
+        friend bool operator> ( const_iterator const & a, const_iterator const & b ) { return a.i_ >  b.i_; }
+        friend bool operator<=( const_iterator const & a, const_iterator const & b ) { return a.i_ <= b.i_; }
+        friend bool operator>=( const_iterator const & a, const_iterator const & b ) { return a.i_ >= b.i_; }
+
+    private:
+        optional_vector const * v_;
+        size_type i_;
+    };
+
+    typedef const_iterator iterator;
+
+    // construction of an empty sequence or of n disengaged elements:
+
+    optional_vector()
+    {}
+
+    explicit optional_vector( size_type n )
+    : values_( n )
+    , bitmap_( bitmap_size( n ) )
+    {}
+
+    // iterators
+
+    const_iterator begin() const
+    {
+        return const_iterator( this, 0 );
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator( this, size() );
+    }
+
+    // capacity
+
+    size_type size() const
+    {
+        return values_.size();
+    }
+
+    bool empty() const
+    {
+        return values_.empty();
+    }
+
+    size_type capacity() const
+    {
+        return values_.capacity();
+    }
+
+    void reserve( size_type n )
+    {
+        values_.reserve( n );
+        bitmap_.reserve( bitmap_size( n ) );
+    }
+
+    // element access
+
+    bool has_value( size_type i ) const
+    {
+        return assert( i < size() ),
+            0 != ( ( static_cast<unsigned>( bitmap_[ i / 8 ] ) >> ( i % 8 ) ) & 1u );
+    }
+
+    optional<T> operator[]( size_type i ) const
+    {
+        return has_value( i ) ? optional<T>( values_[ i ] ) : optional<T>();
+    }
+
+#if ! optional_USES_STD_OPTIONAL
+    // reference to the value of element i, without copying it:
+
+    optional<T &> ref( size_type i )
+    {
+        return has_value( i ) ? optional<T &>( values_[ i ] ) : optional<T &>();
+    }
+
+    optional<T const &> ref( size_type i ) const
+    {
+        return has_value( i ) ? optional<T const &>( values_[ i ] ) : optional<T const &>();
+    }
+#endif
+
+    // dense values, also of disengaged elements, and validity bitmap of size() bits:
+
+    T const * values() const
+    {
+        return values_.empty() ? 0 : &values_[0];
+    }
+
+    bitmap_type const * bitmap() const
+    {
+        return bitmap_.empty() ? 0 : &bitmap_[0];
+    }
+
+    // modifiers
+
+    void push_back( optional<T> const & v )
+    {
+        // reserve the bitmap first, so that a throwing push_back leaves the sequence unchanged;
+        // grow it geometrically, as reserve() may allocate exactly the requested size:
+
+        if ( bitmap_size( size() + 1 ) > bitmap_.capacity() )
+            bitmap_.reserve( 2 * bitmap_.capacity() + 1 );
+        values_.push_back( v.has_value() ? *v : T() );
+        bitmap_.resize( bitmap_size( size() ), 0 );
+
+        if ( v.has_value() )
+            set_bit( size() - 1 );
+    }
+
+    void pop_back()
+    {
+        assert( ! empty() );
+
+        clear_bit( size() - 1 );
+        values_.pop_back();
+        bitmap_.resize( bitmap_size( size() ) );
+    }
+
+    void set( size_type i, optional<T> const & v )
+    {
+        assert( i < size() );
+
+        if ( v.has_value() )
+        {
+            values_[ i ] = *v;
+            set_bit( i );
+        }
+        else
+        {
+            reset( i );
+        }
+    }
+
+    void reset( size_type i )
+    {
+        assert( i < size() );
+
+        values_[ i ] = T();
+        clear_bit( i );
+    }
+
+    void resize( size_type n )
+    {
+        for ( size_type i = n; i < size(); ++i )
+            clear_bit( i );
+
+        values_.resize( n );
+        bitmap_.resize( bitmap_size( n ), 0 );
+    }
+
+    void clear()
+    {
+        values_.clear();
+        bitmap_.clear();
+    }
+
+    void swap( optional_vector & other )
+    {
+        values_.swap( other.values_ );
+        bitmap_.swap( other.bitmap_ );
+    }
+
+private:
+    static size_type bitmap_size( size_type n )
+    {
+        return ( n + 7 ) / 8;
+    }
+
+    void set_bit( size_type i )
+    {
+        bitmap_[ i / 8 ] = static_cast<bitmap_type>( bitmap_[ i / 8 ] | ( 1u << ( i % 8 ) ) );
+    }
+
+    void clear_bit( size_type i )
+    {
+        bitmap_[ i / 8 ] = static_cast<bitmap_type>( bitmap_[ i / 8 ] & ~( 1u << ( i % 8 ) ) );
+    }
+
+private:
+    std::vector< T > values_;
+    std::vector< bitmap_type > bitmap_;
+
+    friend struct detail::column_access;
+};
+
+namespace detail {
+
+struct column_access
+{
+    template< typename T >
+    static T * values( optional_vector<T> & v )
+    {
+        return v.values_.empty() ? 0 : &v.values_[0];
+    }
+
+    template< typename T >
+    static unsigned char * bitmap( optional_vector<T> & v )
+    {
+        return v.bitmap_.empty() ? 0 : &v.bitmap_[0];
+    }
+};
+
+} // namespace detail
+
+template< typename T >
+void swap( optional_vector<T> & x, optional_vector<T> & y )
+{
+    x.swap( y );
+}
+
+} // namespace optional_bare
+
+using namespace optional_bare;
+
+} // namespace nonstd
+
+#endif // NONSTD_OPTIONAL_VECTOR_HPP
@@ -0,0 +1,327 @@
+//
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef NONSTD_SLOT_MAP_HPP
+#define NONSTD_SLOT_MAP_HPP
+
+#include "nonstd/optional.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace nonstd { namespace optional_bare {
+
+// Pool of objects addressed by handles of an index and a generation. The objects
+// are stored densely in a std::vector<T>, so that iteration visits live objects
+// only. A slot per handle index holds the generation and the position of its
+// object; the slot of an erased object instead holds the index of the next free
+// slot, which forms an intrusive free list, and its generation is incremented so
+// that the handles to the erased object no longer match. A live slot has an odd
+// generation and only a handle of an odd generation matches, so that a
+// default-constructed handle never does. Erasing moves the last object into the
+// gap. Insert, erase and lookup take constant time and, once the vectors have
+// grown to the peak size, do not allocate.
+// Note: requires T to be copyable with C++98 and movable with C++11; erasure and
+// insertion invalidate iterators and references, but not handles.
+
+template< typename T >
+class slot_map
+{
+public:
+    typedef T                                       value_type;
+    typedef std::size_t                             size_type;
+    typedef typename std::vector<T>::iterator       iterator;
+    typedef typename std::vector<T>::const_iterator const_iterator;
+
+    struct handle
+    {
+        size_type index;
+        unsigned int generation;
+
+        handle()
+        : index( 0 ), generation( 0 )
+        {}
+
+        handle( size_type i, unsigned int g )
+        : index( i ), generation( g )
+        {}
+
+        friend bool operator==( handle const & a, handle const & b ) { return a.index == b.index && a.generation == b.generation; }
+        friend bool operator!=( handle const & a, handle const & b ) { return !( a == b ); }
+    };
+
+    slot_map()
+    : free_( npos() )
+    {}
+
+    // iterators over the live objects, in no particular order:
+
+    iterator       begin()       { return values_.begin(); }
+    iterator       end()         { return values_.end();   }
+    const_iterator begin() const { return values_.begin(); }
+    const_iterator end()   const { return values_.end();   }
+
+    // handle of the object at position i of the iteration:
+
+    handle handle_at( size_type i ) const
+    {
+        assert( i < size() );
+
+        size_type const s = slot_of_[ i ];
+        return handle( s, slots_[ s ].generation );
+    }
+
+    // capacity
+
+    size_type size() const
+    {
+        return values_.size();
+    }
+
+    bool empty() const
+    {
+        return values_.empty();
+    }
+
+    void reserve( size_type n )
+    {
+        values_.reserve( n );
+        slot_of_.reserve( n );
+        slots_.reserve( n );
+    }
+
+    // lookup
+
+    bool contains( handle h ) const
+    {
+        return ( h.generation & 1u ) != 0 && h.index < slots_.size() && slots_[ h.index ].generation == h.generation;
+    }
+
+    // copy of the object of a handle:
+
+    optional<T> get( handle h ) const
+    {
+        return contains( h ) ? optional<T>( values_[ slots_[ h.index ].index ] ) : optional<T>();
+    }
+
+#if ! optional_USES_STD_OPTIONAL
+    // reference to the object of a handle, without copying it:
+
+    optional<T &> find( handle h )
+    {
+        return contains( h ) ? optional<T &>( values_[ slots_[ h.index ].index ] ) : optional<T &>();
+    }
+
+    optional<T const &> find( handle h ) const
+    {
+        return contains( h ) ? optional<T const &>( values_[ slots_[ h.index ].index ] ) : optional<T const &>();
+    }
+#endif
+
+    T & operator[]( handle h )
+    {
+        return assert( contains( h ) ), values_[ slots_[ h.index ].index ];
+    }
+
+    T const & operator[]( handle h ) const
+    {
+        return assert( contains( h ) ), values_[ slots_[ h.index ].index ];
+    }
+
+    // modifiers
+
+    // add an object in the first free slot, or in a new slot:
+
+#if optional_CPP11_OR_GREATER
+
+    handle insert( T const & value )
+    {
+        return emplace( value );
+    }
+
+    handle insert( T && value )
+    {
+        return emplace( std::move( value ) );
+    }
+
+    // add an object constructed in place from args:
+
+    template< typename... Args >
+    handle emplace( Args&&... args )
+    {
+        size_type const s = claim_slot();
+
+        slot_of_.push_back( s );
+        pop_guard guard( slot_of_ );
+        values_.emplace_back( std::forward<Args>( args )... );
+        guard.dismiss();
+
+        return commit_slot( s );
+    }
+
+#else // optional_CPP11_OR_GREATER
+
+    handle insert( T const & value )
+    {
+        size_type const s = claim_slot();
+
+        slot_of_.push_back( s );
+        pop_guard guard( slot_of_ );
+        values_.push_back( value );
+        guard.dismiss();
+
+        return commit_slot( s );
+    }
+
+#endif // optional_CPP11_OR_GREATER
+
+    // remove the object of a handle; return whether the handle was valid:
+
+    bool erase( handle h )
+    {
+        if ( ! contains( h ) )
+            return false;
+
+        size_type const i = slots_[ h.index ].index;
+        size_type const last = values_.size() - 1;
+
+        if ( i != last )
+        {
+#if optional_CPP11_OR_GREATER
+            values_[ i ] = std::move( values_[ last ] );
+#else
+            values_[ i ] = values_[ last ];
+#endif
+            slot_of_[ i ] = slot_of_[ last ];
+            slots_[ slot_of_[ i ] ].index = i;
+        }
+        values_.pop_back();
+        slot_of_.pop_back();
+
+        slots_[ h.index ].index = free_;
+        slots_[ h.index ].generation += 1;
+        free_ = h.index;
+        return true;
+    }
+
+    // remove the object of a handle and return it, or return nullopt:
+
+    optional<T> take( handle h )
+    {
+        if ( ! contains( h ) )
+            return optional<T>();
+
+#if optional_CPP11_OR_GREATER
+        optional<T> value( std::move( values_[ slots_[ h.index ].index ] ) );
+#else
+        optional<T> value( values_[ slots_[ h.index ].index ] );
+#endif
+        erase( h );
+        return value;
+    }
+
+    void clear()
+    {
+        for ( size_type i = 0; i < slot_of_.size(); ++i )
+        {
+            slot & s = slots_[ slot_of_[ i ] ];
+            s.index = free_;
+            s.generation += 1;
+            free_ = slot_of_[ i ];
+        }
+        values_.clear();
+        slot_of_.clear();
+    }
+
+    void swap( slot_map & other )
+    {
+        using std::swap;
+        values_.swap( other.values_ );
+        slot_of_.swap( other.slot_of_ );
+        slots_.swap( other.slots_ );
+        swap( free_, other.free_ );
+    }
+
+private:
+    static size_type npos()
+    {
+        return static_cast<size_type>( -1 );
+    }
+
+    // first free slot, after adding a new slot to the free list if there is none;
+    // the new slot joins the free list first, so that a throwing insertion of the
+    // object leaves the handles and objects unchanged:
+
+    size_type claim_slot()
+    {
+        if ( free_ == npos() )
+        {
+            slots_.push_back( slot( npos(), 0 ) );
+            free_ = slots_.size() - 1;
+        }
+        return free_;
+    }
+
+    // take free slot s off the free list for the object that was added last:
+
+    handle commit_slot( size_type s )
+    {
+        free_ = slots_[ s ].index;
+        slots_[ s ].index = values_.size() - 1;
+        slots_[ s ].generation += 1;
+
+        return handle( s, slots_[ s ].generation );
+    }
+
+    // position of the object of a live slot, or the next free slot:
+
+    struct slot
+    {
+        size_type index;
+        unsigned int generation;
+
+        slot( size_type i, unsigned int g )
+        : index( i ), generation( g )
+        {}
+    };
+
+    // remove the last element of a vector on scope exit, unless dismissed:
+
+    struct pop_guard
+    {
+        std::vector< size_type > * v;
+
+        explicit pop_guard( std::vector< size_type > & x ) : v( &x ) {}
+        ~pop_guard() { if ( v ) v->pop_back(); }
+
+        void dismiss() { v = 0; }
+    };
+
+private:
+    std::vector< T > values_;
+    std::vector< size_type > slot_of_;
+    std::vector< slot > slots_;
+    size_type free_;
+};
+
+template< typename T >
+void swap( slot_map<T> & x, slot_map<T> & y )
+{
+    x.swap( y );
+}
+
+} // namespace optional_bare
+
+using namespace optional_bare;
+
+} // namespace nonstd
+
+#endif // NONSTD_SLOT_MAP_HPP
@@ -0,0 +1,307 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.t.hpp"
+#include "nonstd/atomic_optional.hpp"
+
+#if optional_CPP11_OR_GREATER
+# include <cstdint>
+# include <cstring>
+# include <limits>
+# include <thread>
+# include <vector>
+#endif
+
+using namespace nonstd;
+
+namespace {
+
+#if optional_CPP11_OR_GREATER
+
+// payload that needs the wide atomic word:
+
+struct triple
+{
+    std::int32_t a, b, c;
+};
+
+inline bool operator==( triple const & x, triple const & y ) { return x.a == y.a && x.b == y.b && x.c == y.c; }
+
+inline std::ostream & operator<<( std::ostream & os, triple const & x ) { return os << "{" << x.a << "," << x.b << "," << x.c << "}"; }
+
+// run f( i ) on n threads and wait for them:
+
+template< typename F >
+void run_threads( int n, F f )
+{
+    std::vector< std::thread > threads;
+
+    for ( int i = 0; i < n; ++i )
+        threads.emplace_back( f, i );
+
+    for ( auto & t : threads )
+        t.join();
+}
+
+#endif
+
+} // anonymous namespace
+
+CASE( "atomic_optional: Allows to default construct an empty atomic optional" )
+{
+#if optional_CPP11_OR_GREATER
+    atomic_optional<int> a;
+
+    EXPECT_NOT( a.load().has_value() );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Allows to store and load a value and nullopt" )
+{
+#if optional_CPP11_OR_GREATER
+    atomic_optional<int> a( 7 );
+
+    EXPECT( a.load() == 7 );
+
+    a.store( 42 );
+    EXPECT( a.load() == 42 );
+
+    a.store( nullopt );
+    EXPECT( (a.load() == nullopt) );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Allows to exchange the value and to take it out" )
+{
+#if optional_CPP11_OR_GREATER
+    atomic_optional<short> a;
+
+    EXPECT( (a.exchange( short( 1 ) ) == nullopt) );
+    EXPECT( a.exchange( short( 2 ) ) == short( 1 ) );
+    EXPECT( a.take() == short( 2 ) );
+    EXPECT( (a.take() == nullopt) );
+    EXPECT( (a.load() == nullopt) );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Allows to compare and exchange, loading the current value on failure" )
+{
+#if optional_CPP11_OR_GREATER
+    atomic_optional<int> a;
+    optional<int> expected( 0 );
+
+    EXPECT_NOT( a.compare_exchange_strong( expected, 1 ) );
+    EXPECT( (expected == nullopt) );
+
+    EXPECT( a.compare_exchange_strong( expected, 1 ) );
+    EXPECT( a.load() == 1 );
+
+    expected = optional<int>( 1 );
+    while ( ! a.compare_exchange_weak( expected, nullopt ) ) {}
+
+    EXPECT( (a.load() == nullopt) );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Is lock-free for a payload of up to 7 bytes" )
+{
+#if optional_CPP11_OR_GREATER
+    atomic_optional<int> a;
+
+    EXPECT( a.is_lock_free() );
+    EXPECT( sizeof( a ) == sizeof( std::uint64_t ) );
+# if optional_CPP17_OR_GREATER
+    EXPECT( atomic_optional<int>::is_always_lock_free == a.is_lock_free() );
+# endif
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Is lock-free for a double, reserving a signaling NaN" )
+{
+#if optional_CPP11_OR_GREATER
+    atomic_optional<double> a;
+
+    EXPECT( a.is_lock_free() );
+    EXPECT( sizeof( a ) == sizeof( std::uint64_t ) );
+    EXPECT( (a.load() == nullopt) );
+
+    a.store( 1.5 );
+    EXPECT( a.load() == 1.5 );
+
+    a.store( std::numeric_limits<double>::quiet_NaN() );
+    EXPECT( a.load().has_value() );
+    EXPECT( *a.load() != *a.load() );
+
+    a.store( -0.0 );
+    EXPECT( a.take() == 0.0 );
+    EXPECT( (a.load() == nullopt) );
+
+    std::uint64_t const reserved = 0x7ff4000000000001ull;
+    double d;
+    std::memcpy( &d, &reserved, sizeof d );
+
+    a.store( d );
+    EXPECT( (a.load() == nullopt) );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Is lock-free for a payload of 8 bytes with a compact_optional policy" )
+{
+#if optional_CPP11_OR_GREATER
+    typedef sentinel_policy< std::int64_t, INT64_MIN > policy;
+
+    atomic_optional< std::int64_t, policy > a;
+
+    EXPECT( a.is_lock_free() );
+    EXPECT( sizeof( a ) == sizeof( std::uint64_t ) );
+    EXPECT( (a.load() == nullopt) );
+
+    a.store( INT64_MAX );
+    EXPECT( a.load() == INT64_MAX );
+
+    optional<std::int64_t> expected = INT64_MAX;
+    EXPECT( a.compare_exchange_strong( expected, -1 ) );
+    EXPECT( a.take() == -1 );
+
+    a.store( INT64_MIN );
+    EXPECT( (a.load() == nullopt) );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Allows a payload of up to 15 bytes" )
+{
+#if optional_CPP11_OR_GREATER
+    triple const t = { 1, 2, 3 };
+    atomic_optional<triple> a( t );
+    atomic_optional<std::int64_t> b;
+
+    EXPECT( a.load() == t );
+    EXPECT( a.take() == t );
+    EXPECT( (a.load() == nullopt) );
+
+    b.store( INT64_MIN );
+    EXPECT( b.load() == INT64_MIN );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Counts without losing updates under contention" )
+{
+#if optional_CPP11_OR_GREATER
+    int const threads = 4;
+    int const count = 20000;
+    atomic_optional<int> a;
+
+    run_threads( threads, [&]( int )
+    {
+        for ( int i = 0; i < count; ++i )
+        {
+            optional<int> expected = a.load();
+
+            while ( ! a.compare_exchange_weak( expected, expected.value_or( 0 ) + 1 ) ) {}
+        }
+    } );
+
+    EXPECT( a.load() == threads * count );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Hands over each value exactly once via take()" )
+{
+#if optional_CPP11_OR_GREATER
+    int const producers = 2;
+    int const count = 20000;
+    atomic_optional<int> a;
+    std::atomic<long> taken_sum( 0 );
+    std::atomic<int>  taken( 0 );
+
+    run_threads( 2 * producers, [&]( int id )
+    {
+        if ( id < producers )
+        {
+            for ( int i = 1; i <= count; ++i )
+            {
+                optional<int> expected;
+
+                while ( ! a.compare_exchange_weak( expected, i ) )
+                {
+                    expected = nullopt;
+                    std::this_thread::yield();
+                }
+            }
+        }
+        else
+        {
+            while ( taken.load() < producers * count )
+            {
+                if ( optional<int> v = a.take() )
+                {
+                    taken_sum += *v;
+                    ++taken;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    } );
+
+    EXPECT( taken.load() == producers * count );
+    EXPECT( taken_sum.load() == producers * long( count ) * ( count + 1 ) / 2 );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "atomic_optional: Does not tear a wide payload under contention" )
+{
+#if optional_CPP11_OR_GREATER
+    int const count = 20000;
+    atomic_optional<triple> a;
+    std::atomic<int> torn( 0 );
+
+    run_threads( 4, [&]( int id )
+    {
+        for ( int i = 0; i < count; ++i )
+        {
+            if ( id < 2 )
+            {
+                triple const t = { i, i, i };
+                a.store( i % 3 ? optional<triple>( t ) : optional<triple>() );
+            }
+            else if ( optional<triple> v = a.load() )
+            {
+                torn += v->a != v->b || v->b != v->c;
+            }
+        }
+    } );
+
+    EXPECT( torn.load() == 0 );
+#else
+    EXPECT( !!"atomic_optional: not available (no C++11)" );
+#endif
+}
+
+// end of file
@@ -0,0 +1,271 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.t.hpp"
+#include "nonstd/flat_optional_map.hpp"
+
+#include <map>
+#include <string>
+
+using namespace nonstd;
+
+namespace {
+
+// hash that maps all keys to a few values, so that keys share probe sequences:
+
+struct poor_hash
+{
+    std::size_t operator()( int key ) const
+    {
+        return static_cast<std::size_t>( key % 3 );
+    }
+};
+
+// value whose copy throws while 'fail' is set:
+
+struct throwing
+{
+    static bool fail;
+    int value;
+
+    throwing( int v = 0 ) : value( v ) {}
+    throwing( throwing const & other ) : value( other.value ) { if ( fail ) throw 42; }
+    throwing & operator=( throwing const & other ) { value = other.value; return *this; }
+};
+
+bool throwing::fail = false;
+
+// map of n keys 0, 3, 6, ... with value key + 1:
+
+flat_optional_map<int, int> make_map( int n )
+{
+    flat_optional_map<int, int> m;
+
+    for ( int i = 0; i < n; ++i )
+        m.insert( 3 * i, 3 * i + 1 );
+
+    return m;
+}
+
+} // anonymous namespace
+
+CASE( "flat_optional_map: Allows to default construct an empty map" )
+{
+    flat_optional_map<int, int> m;
+
+    EXPECT( m.empty() );
+    EXPECT( m.size() == 0u );
+    EXPECT( m.capacity() == 0u );
+    EXPECT( (m.begin() == m.end()) );
+    EXPECT_NOT( m.contains( 1 ) );
+    EXPECT_NOT( m.get( 1 ).has_value() );
+}
+
+CASE( "flat_optional_map: Allows to insert keys with values and to look them up" )
+{
+    flat_optional_map<int, int> m = make_map( 1000 );
+
+    EXPECT( m.size() == 1000u );
+
+    for ( int i = 0; i < 3000; ++i )
+    {
+        EXPECT( m.contains( i ) == ( i % 3 == 0 ) );
+        EXPECT( m.count( i ) == ( i % 3 == 0 ? 1u : 0u ) );
+    }
+    EXPECT( m.get( 300 ) == 301 );
+    EXPECT( (m.get( 301 ) == nullopt) );
+}
+
+CASE( "flat_optional_map: Keeps the value of a present key on insert" )
+{
+    flat_optional_map<int, int> m;
+
+    EXPECT(     m.insert( 7, 1 ) );
+    EXPECT_NOT( m.insert( 7, 2 ) );
+    EXPECT( m.get( 7 ) == 1 );
+
+    m.insert_or_assign( 7, 3 );
+    EXPECT( m.get( 7 ) == 3 );
+    EXPECT( m.size() == 1u );
+}
+
+CASE( "flat_optional_map: Allows to access and insert a value via operator[]" )
+{
+    flat_optional_map<std::string, int> m;
+
+    m[ "one" ] = 1;
+    ++m[ "one" ];
+    ++m[ "two" ];
+
+    EXPECT( m.size() == 2u );
+    EXPECT( m.get( "one" ) == 2 );
+    EXPECT( m.get( "two" ) == 1 );
+}
+
+CASE( "flat_optional_map: Allows to erase keys, reusing their slots" )
+{
+    flat_optional_map<int, int> m = make_map( 100 );
+    std::size_t const capacity = m.capacity();
+
+    EXPECT( m.erase( 30 ) == 1u );
+    EXPECT( m.erase( 30 ) == 0u );
+    EXPECT( m.erase( 31 ) == 0u );
+    EXPECT_NOT( m.contains( 30 ) );
+    EXPECT( m.contains( 33 ) );
+    EXPECT( m.size() == 99u );
+
+    for ( int round = 0; round < 100; ++round )
+    {
+        m.insert( 30, round );
+        m.erase( 30 );
+        m.insert( 1000 + round, round );
+        m.erase( 1000 + round );
+    }
+
+    EXPECT( m.size() == 99u );
+    EXPECT( m.capacity() == capacity );
+}
+
+CASE( "flat_optional_map: Finds keys of colliding hashes among deleted slots" )
+{
+    flat_optional_map<int, int, poor_hash> m;
+
+    for ( int i = 0; i < 200; ++i )
+        m.insert( i, -i );
+
+    for ( int i = 0; i < 200; i += 2 )
+        m.erase( i );
+
+    EXPECT( m.size() == 100u );
+
+    for ( int i = 0; i < 200; ++i )
+        EXPECT( m.get( i ) == ( i % 2 ? optional<int>( -i ) : optional<int>() ) );
+}
+
+CASE( "flat_optional_map: Allows to reserve room for elements without rehashing" )
+{
+    flat_optional_map<int, int> m( 1000 );
+    std::size_t const capacity = m.capacity();
+
+    for ( int i = 0; i < 1000; ++i )
+        m.insert( i, i );
+
+    EXPECT( capacity >= 1000u );
+    EXPECT( m.capacity() == capacity );
+}
+
+CASE( "flat_optional_map: Allows to iterate over the elements" )
+{
+    flat_optional_map<int, int> m = make_map( 50 );
+    std::map<int, int> seen;
+
+    for ( flat_optional_map<int, int>::const_iterator pos = m.begin(); pos != m.end(); ++pos )
+        seen[ pos->first ] = pos->second;
+
+    EXPECT( seen.size() == 50u );
+    EXPECT( seen.begin()->first == 0 );
+    EXPECT( seen.rbegin()->second == 148 );
+}
+
+CASE( "flat_optional_map: Allows to copy, swap and clear maps" )
+{
+    flat_optional_map<int, int> a = make_map( 20 );
+    flat_optional_map<int, int> b( a );
+    flat_optional_map<int, int> c;
+
+    b.erase( 0 );
+    swap( b, c );
+
+    EXPECT( a.size() == 20u );
+    EXPECT( b.empty() );
+    EXPECT( c.size() == 19u );
+
+    a.clear();
+
+    EXPECT( a.empty() );
+    EXPECT( (a.begin() == a.end()) );
+    EXPECT_NOT( a.contains( 3 ) );
+    EXPECT( a.insert( 3, 4 ) );
+}
+
+CASE( "flat_optional_map: Leaves the map unchanged when constructing an element throws" )
+{
+    flat_optional_map<int, throwing> m;
+
+    for ( int i = 0; i < 14; ++i )
+        m.insert( i, throwing( i ) );
+
+    throwing::fail = true;
+    try { m.insert( 20, throwing( 20 ) ); } catch ( int ) {}
+    try { m.insert( 21, throwing( 21 ) ); } catch ( int ) {}
+    throwing::fail = false;
+
+    EXPECT( m.size() == 14u );
+    EXPECT_NOT( m.contains( 20 ) );
+    EXPECT_NOT( m.contains( 21 ) );
+
+    int n = 0;
+    for ( flat_optional_map<int, throwing>::const_iterator it = m.begin(); it != m.end(); ++it, ++n )
+        EXPECT( it->first == it->second.value );
+
+    EXPECT( n == 14 );
+
+    m.reserve( 100 );
+
+    EXPECT( m.size() == 14u );
+    EXPECT( m.insert( 20, throwing( 20 ) ) );
+    EXPECT( m.get( 20 )->value == 20 );
+}
+
+CASE( "flat_optional_map: Allows to move and to construct elements in place (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    flat_optional_map<std::string, std::string> m;
+
+    std::string key( "key" ), value( "a value that does not fit a small string buffer" );
+
+    EXPECT( m.insert( std::move( key ), std::move( value ) ) );
+    EXPECT( m.get( "key" ) == std::string( "a value that does not fit a small string buffer" ) );
+
+    EXPECT( m.try_emplace( "abc", 3u, 'x' ) );
+    EXPECT_NOT( m.try_emplace( "abc", 3u, 'y' ) );
+    EXPECT( m.get( "abc" ) == std::string( "xxx" ) );
+
+    EXPECT( m.emplace( "def", "ghi" ) );
+    EXPECT_NOT( m.emplace( "def", "jkl" ) );
+    EXPECT( m.get( "def" ) == std::string( "ghi" ) );
+
+    m.insert_or_assign( std::string( "def" ), std::string( "jkl" ) );
+    m.insert_or_assign( std::string( "mno" ), std::string( "pqr" ) );
+    m[ std::string( "stu" ) ] = "vwx";
+
+    EXPECT( m.get( "def" ) == std::string( "jkl" ) );
+    EXPECT( m.get( "mno" ) == std::string( "pqr" ) );
+    EXPECT( m.get( "stu" ) == std::string( "vwx" ) );
+    EXPECT( m.size() == 5u );
+#else
+    EXPECT( !!"flat_optional_map: move and in-place construction are not available (no C++11)" );
+#endif
+}
+
+CASE( "flat_optional_map: Allows to refer to a value via optional<V&>" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"flat_optional_map: find() is not available (std::optional)" );
+#else
+    flat_optional_map<int, std::string> m;
+
+    m.insert( 1, "abc" );
+
+    m.find( 1 )->append( "def" );
+
+    EXPECT( m.get( 1 ) == std::string( "abcdef" ) );
+    EXPECT_NOT( m.find( 2 ).has_value() );
+#endif
+}
+
+// end of file
@@ -0,0 +1,167 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.t.hpp"
+#include "nonstd/lazy_optional.hpp"
+
+#if optional_CPP11_OR_GREATER
+# include <atomic>
+# include <memory>
+# include <stdexcept>
+# include <string>
+# include <thread>
+# include <vector>
+#endif
+
+using namespace nonstd;
+
+CASE( "once_optional: Allows to default construct an uninitialized optional" )
+{
+#if optional_CPP11_OR_GREATER
+    once_optional<int> o;
+
+    EXPECT_NOT( o.has_value() );
+#else
+    EXPECT( !!"once_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "once_optional: Runs the initializer on the first call only" )
+{
+#if optional_CPP11_OR_GREATER
+    once_optional<std::string> o;
+    int calls = 0;
+
+    std::string const & a = o.get_or_init( [&]{ ++calls; return std::string( "abc" ); } );
+    std::string const & b = o.get_or_init( [&]{ ++calls; return std::string( "def" ); } );
+
+    EXPECT( calls == 1 );
+    EXPECT( a == "abc" );
+    EXPECT( &a == &b );
+    EXPECT( o.has_value() );
+#else
+    EXPECT( !!"once_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "once_optional: Stays empty if the initializer throws" )
+{
+#if optional_CPP11_OR_GREATER
+    once_optional<int> o;
+
+    EXPECT_THROWS_AS( o.get_or_init( []() -> int { throw std::runtime_error( "init" ); } ), std::runtime_error );
+    EXPECT_NOT( o.has_value() );
+    EXPECT( o.get_or_init( []{ return 7; } ) == 7 );
+#else
+    EXPECT( !!"once_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "once_optional: Allows to refer to the value via optional<T const&>" )
+{
+#if optional_USES_STD_OPTIONAL || ! optional_CPP11_OR_GREATER
+    EXPECT( !!"once_optional: try_get() is not available (std::optional, no C++11)" );
+#else
+    once_optional<int> o;
+
+    EXPECT_NOT( o.try_get().has_value() );
+
+    int const & value = o.get_or_init( []{ return 42; } );
+
+    EXPECT( o.try_get() == 42 );
+    EXPECT( &*o.try_get() == &value );
+#endif
+}
+
+CASE( "once_optional: Initializes once when threads race for it" )
+{
+#if optional_CPP11_OR_GREATER
+    int const n = 8;
+    once_optional<int> o;
+    std::atomic<int> calls( 0 );
+    std::atomic<int> wrong( 0 );
+    std::vector< std::thread > threads;
+
+    for ( int i = 0; i < n; ++i )
+    {
+        threads.emplace_back( [&]
+        {
+            int const & v = o.get_or_init( [&]
+            {
+                ++calls;
+                std::this_thread::yield();
+                return 42;
+            } );
+            wrong += v != 42;
+        } );
+    }
+
+    for ( auto & t : threads )
+        t.join();
+
+    EXPECT( calls.load() == 1 );
+    EXPECT( wrong.load() == 0 );
+#else
+    EXPECT( !!"once_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "once_optional: Constructs the value in place from the result of the initializer" )
+{
+#if optional_CPP17_OR_GREATER
+    struct immovable
+    {
+        int value;
+
+        explicit immovable( int v ) : value( v ) {}
+        immovable( immovable const & ) = delete;
+        immovable & operator=( immovable const & ) = delete;
+    };
+
+    once_optional<immovable> o;
+
+    EXPECT( o.get_or_init( []{ return immovable( 7 ); } ).value == 7 );
+#else
+    EXPECT( !!"once_optional: guaranteed copy elision is not available (no C++17)" );
+#endif
+}
+
+CASE( "lazy_optional: Runs its initializer on the first get() only" )
+{
+#if optional_CPP11_OR_GREATER
+    int calls = 0;
+    lazy_optional<int> o( [&]{ return ++calls * 10; } );
+
+    EXPECT_NOT( o.has_value() );
+    EXPECT( o.get() == 10 );
+    EXPECT( o.get() == 10 );
+    EXPECT( o.has_value() );
+    EXPECT( calls == 1 );
+#else
+    EXPECT( !!"lazy_optional: not available (no C++11)" );
+#endif
+}
+
+CASE( "lazy_optional: Releases its initializer once the value is initialized" )
+{
+#if optional_CPP11_OR_GREATER
+    auto resource = std::make_shared<int>( 42 );
+    std::weak_ptr<int> observer = resource;
+    lazy_optional<int> o( [resource]{ return *resource; } );
+
+    resource.reset();
+
+    EXPECT_NOT( observer.expired() );
+    EXPECT( o.get() == 42 );
+    EXPECT( observer.expired() );
+    EXPECT( o.get() == 42 );
+#else
+    EXPECT( !!"lazy_optional: not available (no C++11)" );
+#endif
+}
+
+// end of file
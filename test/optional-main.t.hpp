@@ -27,6 +27,7 @@
 
 #include <iosfwd>
 namespace lest { template<typename T> std::ostream & operator<<( std::ostream & os, nonstd::optional<T> const & v ); }
+namespace lest { template<typename T, typename P> std::ostream & operator<<( std::ostream & os, nonstd::compact_optional<T, P> const & v ); }
 
 #include "lest_cpp03.hpp"
 
@@ -43,6 +44,13 @@ inline std::ostream & operator<<( std::ostream & os, nonstd::optional<T> const &
     return os << "[optional:" << (v ? to_string(*v) : "[empty]") << "]";
 }
 
+template< typename T, typename P >
+inline std::ostream & operator<<( std::ostream & os, nonstd::compact_optional<T, P> const & v )
+{
+    using lest::to_string;
+    return os << "[compact_optional:" << (v ? to_string(*v) : "[empty]") << "]";
+}
+
 } // namespace lest
 
 #endif // TEST_OPTIONAL_BARE_H_INCLUDED
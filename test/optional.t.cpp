@@ -9,6 +9,18 @@
 
 #include "optional-main.t.hpp"
 
+#include <climits>
+#include <string>
+
+#if optional_CPP11_OR_GREATER
+# include <functional>
+# include <unordered_set>
+#endif
+
+#if optional_HAVE_THREE_WAY_COMPARISON
+# include <compare>
+#endif
+
 using namespace nonstd;
 
 #if optional_USES_STD_OPTIONAL && defined(__APPLE__)
@@ -21,6 +33,10 @@ namespace {
 
 struct nonpod { nonpod(){} };
 
+// type without std::hash:
+
+struct no_hash {};
+
 // ensure comparison of pointers for lest:
 
 // const void * lest_nullptr = 0;
@@ -44,6 +60,107 @@ private:
     void operator=   ( NoDefaultCopyMove const & );
 };
 
+// count constructions:
+
+struct Counted
+{
+    static int constructed;
+
+    Counted() { ++constructed; }
+    Counted( Counted const & ) { ++constructed; }
+    Counted & operator=( Counted const & ) { return *this; }
+};
+
+int Counted::constructed = 0;
+
+// count destructions:
+
+struct Destructible
+{
+    static int destroyed;
+
+    ~Destructible() { ++destroyed; }
+};
+
+int Destructible::destroyed = 0;
+
+// count the creations of a fallback value:
+
+int fallback_calls = 0;
+
+int make_fallback()
+{
+    ++fallback_calls;
+    return 7;
+}
+
+// count copies of a value constructed from several arguments:
+
+struct Point
+{
+    static int copies;
+
+    int x, y;
+
+    Point( int x_, int y_ ) : x( x_ ), y( y_ ) {}
+    Point( Point const & other ) : x( other.x ), y( other.y ) { ++copies; }
+    Point & operator=( Point const & other ) { x = other.x; y = other.y; ++copies; return *this; }
+};
+
+int Point::copies = 0;
+
+#if optional_HAVE_THREE_WAY_COMPARISON
+
+// count three-way comparisons of a value:
+
+struct Compared
+{
+    static int comparisons;
+
+    int value;
+
+    std::strong_ordering operator<=>( Compared const & other ) const
+    {
+        ++comparisons;
+        return value <=> other.value;
+    }
+
+    bool operator==( Compared const & other ) const { return value == other.value; }
+};
+
+int Compared::comparisons = 0;
+
+struct Record
+{
+    optional<Compared> first;
+    optional<Compared> second;
+
+    auto operator<=>( Record const & ) const = default;
+};
+
+#endif
+
+#if optional_CPP11_OR_GREATER
+
+// record how a value came into being and whether it has been moved from:
+
+struct Tracked
+{
+    enum State { constructed, copy_constructed, move_constructed, copy_assigned, move_assigned, moved_from };
+
+    State state;
+    int   value;
+
+    Tracked( int v = 0 ) : state( constructed ), value( v ) {}
+    Tracked( Tracked const & other ) : state( copy_constructed ), value( other.value ) {}
+    Tracked( Tracked && other ) : state( move_constructed ), value( other.value ) { other.state = moved_from; }
+
+    Tracked & operator=( Tracked const & other ) { state = copy_assigned; value = other.value; return *this; }
+    Tracked & operator=( Tracked && other ) { state = move_assigned; value = other.value; other.state = moved_from; return *this; }
+};
+
+#endif
+
 } // anonymous namespace
 
 //
@@ -70,15 +187,26 @@ CASE( "optional: Allows to explicitly construct a disengaged, empty optional via
     EXPECT( !a );
 }
 
-#ifdef optional_bare_CONFIG_CONFIRMS_COMPILATION_ERRORS
-CASE( "optional: Disallows to default construct an empty optional with a non-default-constructible (define optional_bare_CONFIG_CONFIRMS_COMPILATION_ERRORS)" )
+CASE( "optional: Allows to default construct an empty optional with a non-default-constructible" )
 {
 //  FAILS: NoDefaultCopyMove x;
     optional<NoDefaultCopyMove> a;
 
     EXPECT( !a );
 }
-#endif
+
+CASE( "optional: Does not construct a value for an empty optional" )
+{
+    Counted::constructed = 0;
+
+    optional<Counted> a;
+    optional<Counted> b( nullopt );
+    optional<Counted> c( a );
+
+    a = b;
+
+    EXPECT( Counted::constructed == 0 );
+}
 
 CASE( "optional: Allows to copy-construct from empty optional" )
 {
@@ -135,6 +263,50 @@ CASE( "optional: Allows to copy-construct from empty optional with different val
     EXPECT_NOT( b );
 }
 
+CASE( "optional: Allows to move-construct from optional (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    optional<Tracked> a( Tracked( 7 ) );
+
+    optional<Tracked> b( std::move( a ) );
+
+    EXPECT( b.has_value() );
+    EXPECT( b->value == 7 );
+    EXPECT( b->state == Tracked::move_constructed );
+    EXPECT( a->state == Tracked::moved_from );
+#else
+    EXPECT( !!"optional: move-construction is not available (no C++11)" );
+#endif
+}
+
+CASE( "optional: Allows to move-construct from value (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    Tracked t( 7 );
+
+    optional<Tracked> a( std::move( t ) );
+
+    EXPECT( a.has_value() );
+    EXPECT( a->value == 7 );
+    EXPECT( a->state == Tracked::move_constructed );
+    EXPECT( t.state  == Tracked::moved_from );
+#else
+    EXPECT( !!"optional: move-construction is not available (no C++11)" );
+#endif
+}
+
+CASE( "optional: Allows to in-place construct from arguments" )
+{
+    Point::copies = 0;
+
+    optional<Point> a( in_place, 3, 4 );
+
+    EXPECT( a.has_value() );
+    EXPECT( a->x == 3 );
+    EXPECT( a->y == 4 );
+    EXPECT( Point::copies == 0 );
+}
+
 // assignment:
 
 CASE( "optional: Allows to assign nullopt to disengage" )
@@ -218,6 +390,23 @@ CASE( "optional: Allows to copy-assign from empty optional with different value
     EXPECT_NOT( a );
 }
 
+CASE( "optional: Allows to move-assign from optional (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    optional<Tracked> a( Tracked( 7 ) );
+    optional<Tracked> b( Tracked( 3 ) );
+
+    b = std::move( a );
+
+    EXPECT( b.has_value() );
+    EXPECT( b->value == 7 );
+    EXPECT( b->state == Tracked::move_assigned );
+    EXPECT( a->state == Tracked::moved_from );
+#else
+    EXPECT( !!"optional: move-assignment is not available (no C++11)" );
+#endif
+}
+
 // swap:
 
 CASE( "optional: Allows to swap with other optional (member)" )
@@ -331,6 +520,119 @@ CASE( "optional: Allows to obtain value or default via value_or()" )
     }}
 }
 
+CASE( "optional: Allows to move out value via rvalue operator*() and value() (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    SETUP( "" ) {
+        optional<Tracked> a( Tracked( 7 ) );
+
+    SECTION( "operator*() && moves value out" ) {
+        Tracked t( *std::move( a ) );
+        EXPECT( t.value == 7 );
+        EXPECT( t.state == Tracked::move_constructed );
+        EXPECT( a->state == Tracked::moved_from );
+    }
+    SECTION( "value() && moves value out" ) {
+        Tracked t( opt_value( std::move( a ) ) );
+        EXPECT( t.value == 7 );
+        EXPECT( t.state == Tracked::move_constructed );
+        EXPECT( a->state == Tracked::moved_from );
+    }}
+#else
+    EXPECT( !!"optional: rvalue observers are not available (no C++11)" );
+#endif
+}
+
+CASE( "optional: Allows to move out value or default via rvalue value_or() (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    SETUP( "" ) {
+        optional<Tracked> d;
+        optional<Tracked> e( Tracked( 42 ) );
+
+    SECTION( "value_or( 7 ) && moves value out of non-empty optional" ) {
+        Tracked t( std::move( e ).value_or( 7 ) );
+        EXPECT( t.value == 42 );
+        EXPECT( e->state == Tracked::moved_from );
+    }
+    SECTION( "value_or( 7 ) && yields default for empty optional" ) {
+        Tracked t( std::move( d ).value_or( 7 ) );
+        EXPECT( t.value == 7 );
+    }}
+#else
+    EXPECT( !!"optional: rvalue value_or() is not available (no C++11)" );
+#endif
+}
+
+CASE( "optional: Allows to obtain value or lazily created fallback via value_or_else()" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional: value_or_else() is not available (std::optional)" );
+#else
+    SETUP( "" ) {
+        fallback_calls = 0;
+        optional<int> d;
+        optional<int> e( 42 );
+
+    SECTION( "value_or_else() yields value for non-empty optional without creating the fallback" ) {
+        EXPECT( e.value_or_else( make_fallback ) == 42 );
+        EXPECT( fallback_calls == 0 );
+    }
+    SECTION( "value_or_else() yields fallback for empty optional" ) {
+        EXPECT( d.value_or_else( make_fallback ) == 7 );
+        EXPECT( fallback_calls == 1 );
+    }}
+#endif
+}
+
+CASE( "optional: Allows to chain operations via and_then() (C++11)" )
+{
+#if optional_USES_STD_OPTIONAL || ! optional_CPP11_OR_GREATER
+    EXPECT( !!"optional: and_then() is not available (std::optional, no C++11)" );
+#else
+    auto half = []( int x ) { return x % 2 ? optional<int>() : optional<int>( x / 2 ); };
+
+    EXPECT( optional<int>( 8 ).and_then( half ).and_then( half ) == 2 );
+    EXPECT( optional<int>( 6 ).and_then( half ).and_then( half ).has_value() == false );
+    EXPECT( optional<int>().and_then( half ).has_value() == false );
+#endif
+}
+
+CASE( "optional: Allows to transform the value via transform() (C++11)" )
+{
+#if optional_USES_STD_OPTIONAL || ! optional_CPP11_OR_GREATER
+    EXPECT( !!"optional: transform() is not available (std::optional, no C++11)" );
+#else
+    optional<int> const e( 42 );
+    optional<std::string> s( "abc" );
+
+    EXPECT( e.transform( []( int x ) { return x / 2.0; } ) == 21.0 );
+    EXPECT( optional<int>().transform( []( int x ) { return x + 1; } ).has_value() == false );
+    EXPECT( s.transform( []( std::string & x ) { return x.size(); } ) == 3u );
+    EXPECT( std::move( s ).transform( []( std::string && x ) { return std::string( std::move( x ) ); } ) == std::string( "abc" ) );
+#endif
+}
+
+CASE( "optional: Allows to obtain an alternative optional via or_else() (C++11)" )
+{
+#if optional_USES_STD_OPTIONAL || ! optional_CPP11_OR_GREATER
+    EXPECT( !!"optional: or_else() is not available (std::optional, no C++11)" );
+#else
+    SETUP( "" ) {
+        fallback_calls = 0;
+        auto other = []() { return optional<int>( make_fallback() ); };
+
+    SECTION( "or_else() yields the non-empty optional without invoking f" ) {
+        EXPECT( optional<int>( 42 ).or_else( other ) == 42 );
+        EXPECT( fallback_calls == 0 );
+    }
+    SECTION( "or_else() yields the optional from f for an empty optional" ) {
+        EXPECT( optional<int>().or_else( other ) == 7 );
+        EXPECT( fallback_calls == 1 );
+    }}
+#endif
+}
+
 CASE( "optional: Throws bad_optional_access at disengaged access" )
 {
     EXPECT_THROWS_AS( opt_value( optional<int>() ), bad_optional_access );
@@ -338,6 +640,28 @@ CASE( "optional: Throws bad_optional_access at disengaged access" )
 
 // modifiers:
 
+CASE( "optional: Allows to emplace a value from arguments" )
+{
+    SETUP( "" ) {
+        Point::copies = 0;
+        optional<Point> d;
+        optional<Point> e( in_place, 1, 2 );
+
+    SECTION( "emplace() engages an empty optional" ) {
+        Point & p = d.emplace( 3, 4 );
+        EXPECT( d.has_value() );
+        EXPECT( &p == &*d );
+        EXPECT( p.x == 3 );
+        EXPECT( Point::copies == 0 );
+    }
+    SECTION( "emplace() replaces the value of an engaged optional" ) {
+        e.emplace( 5, 6 );
+        EXPECT( e->x == 5 );
+        EXPECT( e->y == 6 );
+        EXPECT( Point::copies == 0 );
+    }}
+}
+
 CASE( "optional: Allows to reset content" )
 {
     optional<int> a = 7;
@@ -347,6 +671,99 @@ CASE( "optional: Allows to reset content" )
     EXPECT_NOT( a.has_value() );
 }
 
+CASE( "optional: Destroys the value when it becomes empty" )
+{
+    SETUP( "" ) {
+        Destructible::destroyed = 0;
+        optional<Destructible> d;
+        optional<Destructible> e( in_place );
+
+    SECTION( "reset() destroys the value" ) {
+        e.reset();
+        EXPECT( Destructible::destroyed == 1 );
+        e.reset();
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "assigning nullopt destroys the value" ) {
+        e = nullopt;
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "assigning an empty optional destroys the value" ) {
+        e = d;
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "emplace() destroys the previous value" ) {
+        e.emplace();
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "swap with an empty optional destroys the moved-from value" ) {
+        swap( d, e );
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "destruction of an engaged optional destroys the value" ) {
+        { optional<Destructible> o( in_place ); }
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "destruction of an empty optional does not destroy a value" ) {
+        { optional<Destructible> o; }
+        EXPECT( Destructible::destroyed == 0 );
+    }}
+}
+
+CASE( "optional: Allows to recycle the value, disengaging while keeping it alive" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional: recycle() is not available (std::optional)" );
+#else
+    SETUP( "" ) {
+        Destructible::destroyed = 0;
+        optional<Destructible> e( in_place );
+        e.recycle();
+
+    SECTION( "recycle() disengages without destroying the value" ) {
+        EXPECT_NOT( e.has_value() );
+        EXPECT( Destructible::destroyed == 0 );
+    }
+    SECTION( "reset() destroys a recycled value" ) {
+        e.reset();
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "emplace() destroys a recycled value" ) {
+        e.emplace();
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "destruction destroys a recycled value" ) {
+        { optional<Destructible> o( in_place ); o.recycle(); }
+        EXPECT( Destructible::destroyed == 1 );
+    }
+    SECTION( "copy construction from a recycled optional yields an empty optional" ) {
+        optional<Destructible> c( e );
+        EXPECT_NOT( c.has_value() );
+    }}
+#endif
+}
+
+CASE( "optional: Allows to reuse a recycled value via assign_reuse()" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional: assign_reuse() is not available (std::optional)" );
+#else
+    std::string const longer( 100, 'x' );
+    std::string const shorter( 10, 'y' );
+    optional<std::string> a( longer );
+
+    std::string::size_type const capacity = a->capacity();
+    a.recycle();
+
+    EXPECT( a.assign_reuse( shorter ) == shorter );
+    EXPECT( a.has_value() );
+    EXPECT( a->capacity() == capacity );
+
+    a.reset();
+    EXPECT( a.assign_reuse( shorter ) == shorter );
+#endif
+}
+
 //
 // optional non-member functions:
 //
@@ -456,6 +873,82 @@ CASE( "optional: Provides mixed-type relational operators" )
     relop<char, int, long>( lest_env );
 }
 
+CASE( "optional: Provides relational operators for floating-point value types" )
+{
+    relop<double, double, double>( lest_env );
+}
+
+CASE( "optional: Provides relational operators that ignore the value of a reset optional" )
+{
+    optional<int> d;
+    optional<int> r( 7 );
+    optional<int> e( 7 );
+
+    r.reset();
+
+    EXPECT(  (r == d) );
+    EXPECT( !(r == e) );
+    EXPECT(  (r <  e) );
+    EXPECT( !(r <  d) );
+    EXPECT( !(e <  r) );
+    EXPECT(  (e >  r) );
+}
+
+CASE( "optional: Provides three-way comparison (C++20)" )
+{
+#if optional_HAVE_THREE_WAY_COMPARISON
+    optional<int> const d;
+    optional<int> const a( 1 );
+    optional<int> const b( 2 );
+
+    EXPECT( std::is_lt( a <=> b ) );
+    EXPECT( std::is_gt( b <=> a ) );
+    EXPECT( std::is_eq( a <=> a ) );
+    EXPECT( std::is_lt( d <=> a ) );
+    EXPECT( std::is_eq( d <=> d ) );
+
+    EXPECT( std::is_eq( d <=> nullopt ) );
+    EXPECT( std::is_gt( a <=> nullopt ) );
+    EXPECT( std::is_lt( nullopt <=> a ) );
+
+    EXPECT( std::is_lt( a <=> 2 ) );
+    EXPECT( std::is_lt( d <=> 2 ) );
+    EXPECT( std::is_gt( 2 <=> a ) );
+#else
+    EXPECT( !!"optional: operator<=> is not available (no C++20)" );
+#endif
+}
+
+CASE( "optional: Provides three-way comparison with the comparison category of the value type (C++20)" )
+{
+#if optional_HAVE_THREE_WAY_COMPARISON
+    optional<std::string> s;
+    optional<double> f;
+
+    EXPECT( (std::is_same< decltype( s <=> s ), std::strong_ordering >::value) );
+    EXPECT( (std::is_same< decltype( f <=> f ), std::partial_ordering >::value) );
+    EXPECT( (std::is_same< decltype( f <=> 1.0 ), std::partial_ordering >::value) );
+    EXPECT( (std::is_same< decltype( f <=> nullopt ), std::strong_ordering >::value) );
+#else
+    EXPECT( !!"optional: operator<=> is not available (no C++20)" );
+#endif
+}
+
+CASE( "optional: Compares values once per key via defaulted three-way comparison (C++20)" )
+{
+#if optional_HAVE_THREE_WAY_COMPARISON
+    Record x = { Compared{ 1 }, Compared{ 2 } };
+    Record y = { Compared{ 1 }, Compared{ 3 } };
+
+    Compared::comparisons = 0;
+
+    EXPECT( std::is_lt( x <=> y ) );
+    EXPECT( Compared::comparisons == 2 );
+#else
+    EXPECT( !!"optional: operator<=> is not available (no C++20)" );
+#endif
+}
+
 CASE( "make_optional: Allows to copy-construct optional" )
 {
     S s( 7 );
@@ -463,6 +956,397 @@ CASE( "make_optional: Allows to copy-construct optional" )
     EXPECT( make_optional( s )->value == 7 );
 }
 
+CASE( "make_optional: Allows to in-place construct optional from arguments" )
+{
+    optional<Point> a = make_optional<Point>( 3, 4 );
+
+    EXPECT( a->x == 3 );
+    EXPECT( a->y == 4 );
+}
+
+CASE( "optional: Is trivially copyable and destructible for a trivially copyable value type (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    static_assert( std::is_trivially_copyable< optional<int> >::value, "optional<int> must be trivially copyable" );
+    static_assert( std::is_trivially_copyable< optional<Integer> >::value, "optional<Integer> must be trivially copyable" );
+    static_assert( std::is_trivially_destructible< optional<int> >::value, "optional<int> must be trivially destructible" );
+    static_assert( std::is_trivially_copy_constructible< optional<double> >::value, "optional<double> must be trivially copy constructible" );
+    static_assert( std::is_trivially_move_constructible< optional<double> >::value, "optional<double> must be trivially move constructible" );
+    static_assert( ! std::is_trivially_copyable< optional<std::string> >::value, "optional<std::string> must not be trivially copyable" );
+    static_assert( ! std::is_trivially_destructible< optional<std::string> >::value, "optional<std::string> must not be trivially destructible" );
+
+    EXPECT( std::is_trivially_copyable< optional<int> >::value );
+#else
+    EXPECT( !!"optional: type traits for triviality are not available (no C++11)" );
+#endif
+}
+
+CASE( "optional: Allows constexpr construction, observers and comparisons (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    constexpr optional<int> e;
+    constexpr optional<int> n( nullopt );
+    constexpr optional<int> a( 7 );
+    constexpr optional<int> b( in_place, 42 );
+    constexpr optional<int> m = make_optional( 3 );
+    constexpr optional<int> table[] = { 1, nullopt, 3 };
+
+    static_assert( ! e.has_value() && ! n, "empty optional must be disengaged" );
+    static_assert( a.has_value() && *a == 7 && *b == 42 && *m == 3, "engaged optional must hold its value" );
+    static_assert( e.value_or( 5 ) == 5 && a.value_or( 5 ) == 7, "value_or() must yield the value or the default" );
+    static_assert( e == n && e < a && a < b && a != b, "optionals must compare" );
+    static_assert( a == 7 && 7 == a && e == nullopt && nullopt < a, "optional must compare with value and nullopt" );
+    static_assert( table[0] == 1 && ! table[1] && table[2].value_or( 0 ) == 3, "table must hold its optionals" );
+#if optional_CPP14_OR_GREATER
+    static_assert( a.value() == 7, "value() must yield the value (C++14)" );
+#endif
+    EXPECT( *a == 7 );
+    EXPECT( (table[1] == nullopt) );
+#else
+    EXPECT( !!"optional: constexpr is not available (no C++11)" );
+#endif
+}
+
+CASE( "std::hash<>: Allows to obtain hash (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    optional<int> const a( 7 );
+    optional<int> const e;
+    optional<std::string> const s( "abc" );
+
+    EXPECT( std::hash< optional<int> >()( a ) == std::hash< optional<int> >()( optional<int>( 7 ) ) );
+    EXPECT( std::hash< optional<std::string> >()( s ) == std::hash< optional<std::string> >()( optional<std::string>( "abc" ) ) );
+    EXPECT( std::hash< optional<int> >()( e ) != std::hash< optional<int> >()( optional<int>( 0 ) ) );
+    EXPECT( std::hash< optional<std::string> >()( optional<std::string>() ) != std::hash< optional<std::string> >()( optional<std::string>( "" ) ) );
+#else
+    EXPECT( !!"std::hash<>: std::hash<> is not available (no C++11)" );
+#endif
+}
+
+CASE( "std::hash<>: Distinguishes an empty optional from any small value (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    std::hash< optional<std::size_t> > const h;
+    std::size_t const empty = h( optional<std::size_t>() );
+
+    for ( std::size_t i = 0; i < 1000; ++i )
+        EXPECT( h( optional<std::size_t>( i ) ) != empty );
+# if ! optional_USES_STD_OPTIONAL
+    EXPECT( h( optional<std::size_t>( static_cast<std::size_t>( 0x9e3779b97f4a7c15ull ) ) ) != empty );
+# endif
+#else
+    EXPECT( !!"std::hash<>: std::hash<> is not available (no C++11)" );
+#endif
+}
+
+CASE( "std::hash<>: Is disabled for a value type without hash (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    EXPECT(     std::is_default_constructible< std::hash< optional<int> > >::value );
+    EXPECT_NOT( std::is_default_constructible< std::hash< optional<no_hash> > >::value );
+    EXPECT_NOT( std::is_copy_constructible   < std::hash< optional<no_hash> > >::value );
+#else
+    EXPECT( !!"std::hash<>: std::hash<> is not available (no C++11)" );
+#endif
+}
+
+CASE( "std::hash<>: Allows to use optional as key of an unordered container (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    std::unordered_set< optional<int> > set;
+
+    set.insert( optional<int>( 1 ) );
+    set.insert( optional<int>() );
+    set.insert( optional<int>( 1 ) );
+
+    EXPECT( set.size() == 2u );
+    EXPECT( set.count( optional<int>() ) == 1u );
+    EXPECT( set.count( optional<int>( 2 ) ) == 0u );
+#else
+    EXPECT( !!"std::hash<>: std::hash<> is not available (no C++11)" );
+#endif
+}
+
+//
+// optional<T&>:
+//
+
+CASE( "optional<T&>: Allows to default construct an empty optional reference" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    optional<int &> a;
+    optional<int &> b( nullopt );
+
+    EXPECT_NOT( a.has_value() );
+    EXPECT_NOT( b.has_value() );
+#endif
+}
+
+CASE( "optional<T&>: Allows to refer to a value without copying it" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    Point::copies = 0;
+    Point p( 1, 2 );
+    optional<Point &> a( p );
+    optional<Point const &> b( a );
+
+    a->x = 3;
+
+    EXPECT( a.has_value() );
+    EXPECT( &*a == &p );
+    EXPECT( b->x == 3 );
+    EXPECT( a.value().y == 2 );
+    EXPECT( Point::copies == 0 );
+#endif
+}
+
+CASE( "optional<T&>: Allows to obtain value or default via value_or()" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    int i = 42;
+    optional<int const &> d;
+    optional<int const &> e( i );
+
+    EXPECT( e.value_or( 7 ) == 42 );
+    EXPECT( d.value_or( 7 ) ==  7 );
+#endif
+}
+
+CASE( "optional<T&>: Allows to rebind via assignment and emplace(), and to reset" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    int i = 1, k = 2;
+    optional<int &> a( i );
+
+    a = k;
+    EXPECT( &*a == &k );
+    EXPECT( i == 1 );
+
+    a.emplace( i );
+    EXPECT( &*a == &i );
+
+    a = nullopt;
+    EXPECT_NOT( a.has_value() );
+
+    a = i;
+    a.reset();
+    EXPECT_NOT( a.has_value() );
+#endif
+}
+
+CASE( "optional<T&>: Allows to swap references" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    int i = 1;
+    optional<int &> a( i );
+    optional<int &> b;
+
+    swap( a, b );
+
+    EXPECT_NOT( a.has_value() );
+    EXPECT( &*b == &i );
+#endif
+}
+
+CASE( "optional<T&>: Throws bad_optional_access at disengaged access" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    EXPECT_THROWS_AS( optional<int &>().value(), bad_optional_access );
+#endif
+}
+
+CASE( "optional<T&>: Provides relational operators" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    int i = 1, k = 2, l = 1;
+    optional<int &> d;
+    optional<int &> a( i );
+    optional<int &> b( k );
+    optional<int &> c( l );
+
+    EXPECT( a == c );
+    EXPECT( a != b );
+    EXPECT( a <  b );
+    EXPECT( d <  a );
+    EXPECT( b >= a );
+    EXPECT( (d == nullopt) );
+    EXPECT( a == 1 );
+    EXPECT( 2 == b );
+    EXPECT( a == optional<int>( 1 ) );
+#endif
+}
+
+CASE( "optional<T&>: Allows to obtain hash of the referred-to value (C++11)" )
+{
+#if optional_USES_STD_OPTIONAL || ! optional_CPP11_OR_GREATER
+    EXPECT( !!"optional<T&>: std::hash<> is not available (std::optional, no C++11)" );
+#else
+    std::string const text( "abc" );
+
+    EXPECT( std::hash< optional<std::string const &> >()( optional<std::string const &>( text ) ) == std::hash< optional<std::string> >()( optional<std::string>( text ) ) );
+    EXPECT( std::hash< optional<std::string const &> >()( optional<std::string const &>() ) == std::hash< optional<std::string> >()( optional<std::string>() ) );
+#endif
+}
+
+CASE( "optional<T&>: Has the size of a pointer" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional<T&>: is not available (std::optional)" );
+#else
+    EXPECT( sizeof( optional<int &> ) == sizeof( int * ) );
+    EXPECT( sizeof( optional<std::string const &> ) == sizeof( std::string const * ) );
+#endif
+}
+
+//
+// compact_optional:
+//
+
+typedef sentinel_policy<int, INT_MIN> int_min_policy;
+
+CASE( "compact_optional: Allows to default construct an empty compact_optional" )
+{
+    compact_optional<int, int_min_policy> a;
+
+    EXPECT_NOT( a.has_value() );
+    EXPECT( (a == nullopt) );
+}
+
+CASE( "compact_optional: Allows to construct from value" )
+{
+    compact_optional<int, int_min_policy> a( 7 );
+
+    EXPECT( a.has_value() );
+    EXPECT( *a == 7 );
+}
+
+CASE( "compact_optional: Represents the reserved value as empty" )
+{
+    compact_optional<int, int_min_policy> a( INT_MIN );
+
+    EXPECT_NOT( a.has_value() );
+}
+
+CASE( "compact_optional: Allows to copy-construct and copy-assign" )
+{
+    compact_optional<int, int_min_policy> a( 7 );
+    compact_optional<int, int_min_policy> b( a );
+    compact_optional<int, int_min_policy> c;
+
+    c = a;
+
+    EXPECT( *b == 7 );
+    EXPECT( *c == 7 );
+}
+
+CASE( "compact_optional: Allows to obtain value via value() and value or default via value_or()" )
+{
+    compact_optional<int, int_min_policy> d;
+    compact_optional<int, int_min_policy> e( 42 );
+
+    EXPECT( e.value() == 42 );
+    EXPECT( e.value_or( 7 ) == 42 );
+    EXPECT( d.value_or( 7 ) ==  7 );
+}
+
+CASE( "compact_optional: Throws bad_optional_access at disengaged access" )
+{
+    EXPECT_THROWS_AS( ( compact_optional<int, int_min_policy>().value() ), bad_optional_access );
+}
+
+CASE( "compact_optional: Allows to reset content and to assign nullopt" )
+{
+    compact_optional<int, int_min_policy> a( 7 );
+    compact_optional<int, int_min_policy> b( 7 );
+
+    a.reset();
+    b = nullopt;
+
+    EXPECT_NOT( a.has_value() );
+    EXPECT_NOT( b.has_value() );
+}
+
+CASE( "compact_optional: Allows to swap engage state and values" )
+{
+    compact_optional<int, int_min_policy> d;
+    compact_optional<int, int_min_policy> e( 42 );
+
+    swap( d, e );
+
+    EXPECT(     d.has_value() );
+    EXPECT_NOT( e.has_value() );
+    EXPECT( *d == 42 );
+}
+
+CASE( "compact_optional: Provides relational operators" )
+{
+    compact_optional<int, int_min_policy> d;
+    compact_optional<int, int_min_policy> e1( 6 );
+    compact_optional<long, sentinel_policy<long, -1L> > e2( 7 );
+
+    EXPECT(   e1 == e1  );
+    EXPECT( !(e1 == d ) );
+    EXPECT(   e1 != e2  );
+    EXPECT(   e1 <  e2  );
+    EXPECT(   d  <  e1  );
+    EXPECT( !(e1 <  d ) );
+    EXPECT(   e1 <= e2  );
+    EXPECT(   e2 >  e1  );
+    EXPECT(   e2 >= e1  );
+
+    EXPECT(  (d       == nullopt) );
+    EXPECT(  (e1      != nullopt) );
+    EXPECT(  (nullopt <  e1     ) );
+    EXPECT(  (e1      >  nullopt) );
+
+    EXPECT(   e1 == 6  );
+    EXPECT(   6  == e1 );
+    EXPECT(   e1 <  7  );
+    EXPECT(   d  <  7  );
+    EXPECT(   7  >  e1 );
+}
+
+CASE( "compact_optional: Has the size of its value type" )
+{
+    EXPECT( sizeof( compact_optional<int, int_min_policy> ) == sizeof( int ) );
+    EXPECT( sizeof( compact_optional<long, sentinel_policy<long, -1L> > ) == sizeof( long ) );
+}
+
+CASE( "compact_optional: Allows constexpr construction, observers and comparisons (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    typedef compact_optional<int, int_min_policy> optional_int;
+
+    constexpr optional_int e;
+    constexpr optional_int a( 7 );
+    constexpr optional_int table[] = { 1, nullopt, 3 };
+
+    static_assert( ! e.has_value() && a.has_value() && *a == 7, "compact_optional must hold its value" );
+    static_assert( e.value_or( 5 ) == 5 && a.value_or( 5 ) == 7, "value_or() must yield the value or the default" );
+    static_assert( e < a && a == 7 && e == nullopt && table[2] > table[0], "compact_optionals must compare" );
+#if optional_CPP14_OR_GREATER
+    static_assert( a.value() == 7, "value() must yield the value (C++14)" );
+#endif
+    EXPECT( *a == 7 );
+#else
+    EXPECT( !!"compact_optional: constexpr is not available (no C++11)" );
+#endif
+}
+
 //
 // Negative tests:
 //
@@ -489,6 +1373,8 @@ CASE("storage_t: Show sizeof various optionals"
          optional_OUTPUT_SIZEOF( double )
          optional_OUTPUT_SIZEOF( long double )
          optional_OUTPUT_SIZEOF( Struct )
+         "sizeof( compact_optional<int, sentinel_policy<int, INT_MIN> > ): " <<
+          sizeof( compact_optional<int, sentinel_policy<int, INT_MIN> > ) << " (" << sizeof(int) << ")\n" <<
          "";
 }
 #undef optional_OUTPUT_SIZEOF
@@ -0,0 +1,1090 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.t.hpp"
+#include "nonstd/optional_algorithm.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <string>
+#include <vector>
+
+using namespace nonstd;
+
+namespace alg = nonstd::optional_algorithm;
+
+namespace {
+
+// column of n elements with value i - 50 at index i, engaged if i % 3 != 0,
+// and with the value 'filler' in the disengaged elements:
+
+template< typename T >
+struct column
+{
+    std::vector<T> values;
+    std::vector<unsigned char> bitmap;
+
+    column( std::size_t n, T filler )
+    : values( n ), bitmap( ( n + 7 ) / 8 )
+    {
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            bool const on = i % 3 != 0;
+            values[i] = on ? static_cast<T>( static_cast<int>( i ) - 50 ) : filler;
+            if ( on )
+                bitmap[ i / 8 ] = static_cast<unsigned char>( bitmap[ i / 8 ] | ( 1u << ( i % 8 ) ) );
+        }
+    }
+
+    T const * data() const { return values.empty() ? 0 : &values[0]; }
+    unsigned char const * bits() const { return bitmap.empty() ? 0 : &bitmap[0]; }
+};
+
+// the same sequence as a range of optional<int>:
+
+std::vector< optional<int> > make_range( std::size_t n )
+{
+    std::vector< optional<int> > v;
+
+    for ( std::size_t i = 0; i < n; ++i )
+        v.push_back( i % 3 != 0 ? optional<int>( static_cast<int>( i ) - 50 ) : optional<int>() );
+
+    return v;
+}
+
+// sum of the engaged values of the sequence:
+
+long long expected_sum( std::size_t n )
+{
+    long long s = 0;
+    for ( std::size_t i = 0; i < n; ++i )
+        s += i % 3 != 0 ? static_cast<long long>( i ) - 50 : 0;
+    return s;
+}
+
+std::size_t expected_count( std::size_t n )
+{
+    return n - ( n + 2 ) / 3;
+}
+
+// single-pass input iterator over a vector: all copies share one position,
+// so that a second pass over a range of them reads nothing:
+
+template< typename T >
+struct single_pass_iterator
+{
+    typedef std::input_iterator_tag iterator_category;
+    typedef T                       value_type;
+    typedef std::ptrdiff_t          difference_type;
+    typedef T const *               pointer;
+    typedef T const &               reference;
+
+    std::vector<T> const * v;
+    std::size_t * pos;
+
+    single_pass_iterator( std::vector<T> const & x, std::size_t * p ) : v( &x ), pos( p ) {}
+
+    bool at_end() const { return pos == 0 || *pos == v->size(); }
+
+    reference operator*() const { return (*v)[ *pos ]; }
+    single_pass_iterator & operator++() { ++*pos; return *this; }
+
+    friend bool operator==( single_pass_iterator const & a, single_pass_iterator const & b ) { return a.at_end() == b.at_end(); }
+    friend bool operator!=( single_pass_iterator const & a, single_pass_iterator const & b ) { return !( a == b ); }
+};
+
+// address of the first element, also of an empty vector:
+
+template< typename T >
+T * ptr( std::vector<T> & v )
+{
+    return v.empty() ? 0 : &v[0];
+}
+
+// irregular pattern of engaged elements, to exercise all bitmap bytes:
+
+bool engaged( std::size_t i )
+{
+    return ( i * 37 + i / 7 ) % 11 < 6;
+}
+
+template< typename T >
+struct pattern
+{
+    std::vector<T> values;
+    std::vector<unsigned char> bitmap;
+    std::vector<T> dense;
+    std::vector<std::size_t> indices;
+
+    explicit pattern( std::size_t n )
+    : values( n ), bitmap( ( n + 7 ) / 8 + 1 )
+    {
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            values[i] = static_cast<T>( 1000 + static_cast<int>( i ) );
+            if ( engaged( i ) )
+            {
+                bitmap[ i / 8 ] = static_cast<unsigned char>( bitmap[ i / 8 ] | ( 1u << ( i % 8 ) ) );
+                dense.push_back( values[i] );
+                indices.push_back( i );
+            }
+        }
+    }
+};
+
+std::size_t const pattern_sizes[] = { 0, 1, 7, 8, 9, 16, 17, 64, 65, 100, 1000 };
+
+// operands of element-wise operations: b is zero at every fifth element and
+// disengaged elements hold values that must not affect the result:
+
+template< typename T >
+struct operands
+{
+    std::vector<T> a, b;
+    std::vector<unsigned char> a_bitmap, b_bitmap;
+
+    explicit operands( std::size_t n )
+    : a( n ), b( n ), a_bitmap( ( n + 7 ) / 8 + 1 ), b_bitmap( ( n + 7 ) / 8 + 1 )
+    {
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            bool const a_on = engaged( i );
+            bool const b_on = i % 4 != 3;
+
+            a[i] = a_on ? static_cast<T>( 3 * static_cast<int>( i ) - 100 ) : garbage();
+            b[i] = b_on ? static_cast<T>( static_cast<int>( i % 5 ) - 2 ) : static_cast<T>( -1 );
+
+            a_bitmap[ i / 8 ] = static_cast<unsigned char>( a_bitmap[ i / 8 ] | ( a_on << ( i % 8 ) ) );
+            b_bitmap[ i / 8 ] = static_cast<unsigned char>( b_bitmap[ i / 8 ] | ( b_on << ( i % 8 ) ) );
+        }
+    }
+
+    static T garbage()
+    {
+        return std::numeric_limits<T>::has_quiet_NaN ? std::numeric_limits<T>::quiet_NaN() : (std::numeric_limits<T>::min)();
+    }
+
+    bool on( std::size_t i ) const
+    {
+        return alg::detail::test( &a_bitmap[0], i ) && alg::detail::test( &b_bitmap[0], i );
+    }
+};
+
+template< typename T > T ref_add( T x, T y ) { return static_cast<T>( x + y ); }
+template< typename T > T ref_sub( T x, T y ) { return static_cast<T>( x - y ); }
+template< typename T > T ref_mul( T x, T y ) { return static_cast<T>( x * y ); }
+template< typename T > T ref_div( T x, T y ) { return static_cast<T>( x / y ); }
+template< typename T > T ref_min( T x, T y ) { return x < y ? x : y; }
+template< typename T > T ref_max( T x, T y ) { return x < y ? y : x; }
+
+template< typename T > bool ref_less ( T x, T y ) { return x <  y; }
+template< typename T > bool ref_equal( T x, T y ) { return x == y; }
+
+// element-wise operation f on columns of size n agrees with reference operation ref:
+
+template< typename T >
+bool check_binary( T * (*f)( T const *, unsigned char const *, T const *, unsigned char const *, std::size_t, T *, unsigned char * ),
+                   T (*ref)( T, T ), bool by_zero, std::size_t n )
+{
+    operands<T> p( n );
+    std::vector<T> out( n + 1, T( 42 ) );
+    std::vector<unsigned char> out_bitmap( ( n + 7 ) / 8 + 1, 0xaa );
+
+    if ( f( ptr( p.a ), &p.a_bitmap[0], ptr( p.b ), &p.b_bitmap[0], n, ptr( out ), &out_bitmap[0] ) != ptr( out ) + n )
+        return false;
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        bool const on = p.on( i ) && ( ! by_zero || p.b[i] != T() );
+
+        if ( alg::detail::test( &out_bitmap[0], i ) != on || out[i] != ( on ? ref( p.a[i], p.b[i] ) : T() ) )
+            return false;
+    }
+    return out[n] == T( 42 ) && out_bitmap[ ( n + 7 ) / 8 ] == 0xaa && ( n % 8 == 0 || out_bitmap[ n / 8 ] >> ( n % 8 ) == 0 );
+}
+
+template< typename T >
+bool check_compare( void (*f)( T const *, unsigned char const *, T const *, unsigned char const *, std::size_t, unsigned char *, unsigned char * ),
+                    bool (*ref)( T, T ), std::size_t n )
+{
+    operands<T> p( n );
+    std::vector<unsigned char> out( ( n + 7 ) / 8 + 1, 0xaa );
+    std::vector<unsigned char> out_bitmap( ( n + 7 ) / 8 + 1, 0xaa );
+
+    f( ptr( p.a ), &p.a_bitmap[0], ptr( p.b ), &p.b_bitmap[0], n, &out[0], &out_bitmap[0] );
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        if ( alg::detail::test( &out_bitmap[0], i ) != p.on( i ) || alg::detail::test( &out[0], i ) != ( p.on( i ) && ref( p.a[i], p.b[i] ) ) )
+            return false;
+    }
+    return out[ ( n + 7 ) / 8 ] == 0xaa && out_bitmap[ ( n + 7 ) / 8 ] == 0xaa;
+}
+
+// engaged elements with gaps longer than a bitmap word:
+
+bool sparse( std::size_t i )
+{
+    return i % 150 < 5 || i % 150 == 77;
+}
+
+// check ffill or bfill of a column of n doubles, engaged by 'on', against
+// a fill element by element; the output must not be written beyond n:
+
+bool check_fill( bool forward, std::size_t n, bool (*on)( std::size_t ), std::size_t limit )
+{
+    std::vector<double> values( n ), out( n + 1, -2 );
+    std::vector<unsigned char> bitmap( ( n + 7 ) / 8 ), out_bitmap( ( n + 7 ) / 8 + 1, 0xaa ), expected( ( n + 7 ) / 8 + 1, 0xaa );
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        values[i] = on( i ) ? static_cast<double>( i ) : -1;
+        bitmap[ i / 8 ] = static_cast<unsigned char>( bitmap[ i / 8 ] | ( on( i ) << ( i % 8 ) ) );
+    }
+
+    if ( forward )
+        alg::ffill( ptr( values ), ptr( bitmap ), n, &out[0], &out_bitmap[0], limit );
+    else
+        alg::bfill( ptr( values ), ptr( bitmap ), n, &out[0], &out_bitmap[0], limit );
+
+    std::fill( expected.begin(), expected.end() - 1, static_cast<unsigned char>( 0 ) );
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        std::size_t gap = 0;
+        std::size_t j = i;
+        while ( j < n && ! on( j ) )
+        {
+            ++gap;
+            j = forward ? j - 1 : j + 1;
+        }
+        bool const filled = j < n && gap <= limit;
+
+        if ( out[i] != ( filled ? static_cast<double>( j ) : 0.0 ) )
+            return false;
+        if ( filled )
+            expected[ i / 8 ] = static_cast<unsigned char>( expected[ i / 8 ] | ( 1u << ( i % 8 ) ) );
+    }
+    return out[n] == -2 && out_bitmap == expected;
+}
+
+std::size_t const fill_limits[] = { 0, 1, 3, 64, 100, std::size_t( -1 ) };
+
+// n optionals of pseudo-random values of both signs, a quarter of them disengaged:
+
+template< typename T >
+std::vector< optional<T> > unsorted( std::size_t n )
+{
+    std::vector< optional<T> > v;
+    unsigned int x = 12345;
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        x = x * 1103515245u + 12345u;
+        int const r = static_cast<int>( ( x >> 8 ) % 2000001 ) - 1000000;
+        v.push_back( x >> 30 != 0 ? optional<T>( static_cast<T>( static_cast<T>( r ) / static_cast<T>( 8 ) ) ) : optional<T>() );
+    }
+    return v;
+}
+
+// check sort_optional against std::sort of the engaged values:
+
+template< typename T, typename Compare >
+bool check_sort( std::size_t n, alg::null_order order, Compare comp )
+{
+    std::vector< optional<T> > v = unsorted<T>( n );
+    std::vector<T> dense;
+
+    alg::compact( v.begin(), v.end(), std::back_inserter( dense ) );
+    std::sort( dense.begin(), dense.end(), comp );
+
+    alg::sort_optional( v.begin(), v.end(), order, comp );
+
+    std::size_t const nulls = n - dense.size();
+    std::size_t const first = order == alg::nulls_first ? nulls : 0;
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        bool const on = first <= i && i < first + dense.size();
+
+        if ( v[i].has_value() != on || ( on && *v[i] != dense[ i - first ] ) )
+            return false;
+    }
+    return true;
+}
+
+// order strings by decreasing length:
+
+struct longer
+{
+    bool operator()( std::string const & a, std::string const & b ) const { return a.size() > b.size(); }
+};
+
+std::size_t const sort_sizes[] = { 0, 1, 2, 10, 255, 256, 1000, 5000 };
+
+// order of doubles by their bits, as sort_optional() orders them with std::less:
+// negative NaNs first, then -inf up to -0.0, +0.0 up to +inf, and positive NaNs:
+
+struct by_bits
+{
+    static unsigned long long key( double x )
+    {
+        unsigned long long u;
+        std::memcpy( &u, &x, sizeof u );
+        return u >> 63 ? ~u : u | ( 1ull << 63 );
+    }
+
+    bool operator()( optional<double> const & x, optional<double> const & y ) const
+    {
+        return ! y ? false : ! x ? true : key( *x ) < key( *y );
+    }
+};
+
+// sequence of n doubles that includes NaNs of both signs, infinities and zeros of both signs:
+
+std::vector< optional<double> > special_doubles( std::size_t n )
+{
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+    double const inf = std::numeric_limits<double>::infinity();
+    double const special[] = { nan, -nan, inf, -inf, 0.0, -0.0, 1.5, -1.5 };
+
+    std::vector< optional<double> > v;
+
+    for ( std::size_t i = 0; i < n; ++i )
+        v.push_back( i % 5 == 0 ? optional<double>() : i % 3 == 0 ? optional<double>( special[ i % 8 ] ) : optional<double>( static_cast<double>( ( i * 7919 ) % 1000 ) - 500 ) );
+
+    return v;
+}
+
+#if optional_CPP11_OR_GREATER
+
+// value that counts its copies:
+
+struct copy_counted
+{
+    static int copies;
+    int value;
+
+    copy_counted( int v = 0 ) : value( v ) {}
+    copy_counted( copy_counted const & other ) : value( other.value ) { ++copies; }
+    copy_counted( copy_counted && other ) : value( other.value ) {}
+    copy_counted & operator=( copy_counted const & other ) { value = other.value; ++copies; return *this; }
+    copy_counted & operator=( copy_counted && other ) { value = other.value; return *this; }
+
+    friend bool operator<( copy_counted const & a, copy_counted const & b ) { return a.value < b.value; }
+};
+
+int copy_counted::copies = 0;
+
+#endif
+
+} // anonymous namespace
+
+CASE( "optional_algorithm: Allows to count the engaged elements of a column" )
+{
+    std::size_t const sizes[] = { 0, 1, 7, 8, 9, 64, 65, 131, 1000 };
+
+    for ( std::size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k )
+    {
+        column<int> c( sizes[k], 0 );
+
+        EXPECT( alg::count( c.bits(), sizes[k] ) == expected_count( sizes[k] ) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to sum the engaged values of an int column" )
+{
+    std::size_t const sizes[] = { 0, 1, 7, 8, 9, 64, 65, 131, 1000 };
+
+    for ( std::size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k )
+    {
+        column<int> c( sizes[k], 123456 );
+
+        EXPECT( alg::sum( c.data(), c.bits(), sizes[k] ) == expected_sum( sizes[k] ) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to sum the engaged values of a double column, ignoring the values of disengaged elements" )
+{
+    std::size_t const sizes[] = { 0, 1, 7, 8, 9, 64, 65, 131, 1000 };
+
+    for ( std::size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k )
+    {
+        column<double> c( sizes[k], std::numeric_limits<double>::quiet_NaN() );
+
+        EXPECT( alg::sum( c.data(), c.bits(), sizes[k] ) == static_cast<double>( expected_sum( sizes[k] ) ) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to sum a column without overflow of the value type" )
+{
+    column<int> c( 100, 0 );
+
+    std::fill( c.values.begin(), c.values.end(), (std::numeric_limits<int>::max)() );
+
+    EXPECT( alg::sum( c.data(), c.bits(), 100 ) == static_cast<long long>( (std::numeric_limits<int>::max)() ) * 66 );
+}
+
+CASE( "optional_algorithm: Allows to obtain the minimum and maximum engaged value of a column" )
+{
+    std::size_t const sizes[] = { 2, 7, 8, 9, 64, 65, 131, 1000 };
+
+    for ( std::size_t k = 0; k < sizeof sizes / sizeof sizes[0]; ++k )
+    {
+        std::size_t const n = sizes[k];
+        int const last = static_cast<int>( n - 1 - ( ( n - 1 ) % 3 == 0 ) ) - 50;
+
+        column<int>    ci( n, -1000 );
+        column<double> cd( n, -1000 );
+
+        EXPECT( alg::min( ci.data(), ci.bits(), n ).value() == -49 );
+        EXPECT( alg::max( ci.data(), ci.bits(), n ).value() == last );
+        EXPECT( alg::min( cd.data(), cd.bits(), n ).value() == -49 );
+        EXPECT( alg::max( cd.data(), cd.bits(), n ).value() == last );
+    }
+}
+
+CASE( "optional_algorithm: Allows to obtain the mean of the engaged values of a column" )
+{
+    column<int> c( 10, 0 );
+
+    EXPECT( alg::mean( c.data(), c.bits(), 10 ).value() == static_cast<double>( expected_sum( 10 ) ) / 6 );
+}
+
+CASE( "optional_algorithm: Yields an empty minimum, maximum and mean for a column without engaged elements" )
+{
+    column<double> c( 1, 0 );
+
+    EXPECT_NOT( alg::min ( c.data(), c.bits(), 1 ).has_value() );
+    EXPECT_NOT( alg::max ( c.data(), c.bits(), 1 ).has_value() );
+    EXPECT_NOT( alg::mean( c.data(), c.bits(), 1 ).has_value() );
+    EXPECT_NOT( alg::min ( c.data(), c.bits(), 0 ).has_value() );
+}
+
+CASE( "optional_algorithm: Allows to reduce a range of optional<T>" )
+{
+    std::size_t const n = 100;
+    std::vector< optional<int> > v = make_range( n );
+
+    EXPECT( alg::count( v.begin(), v.end() ) == expected_count( n ) );
+    EXPECT( alg::sum  ( v.begin(), v.end() ) == expected_sum( n ) );
+    EXPECT( alg::min  ( v.begin(), v.end() ).value() == -49 );
+    EXPECT( alg::max  ( v.begin(), v.end() ).value() ==  48 );
+    EXPECT( alg::mean ( v.begin(), v.end() ).value() == static_cast<double>( expected_sum( n ) ) / static_cast<double>( expected_count( n ) ) );
+}
+
+CASE( "optional_algorithm: Allows to obtain the mean of a single-pass range of optional<T>" )
+{
+    std::size_t const n = 100;
+    std::vector< optional<int> > const v = make_range( n );
+    std::size_t pos = 0;
+
+    single_pass_iterator< optional<int> > const first( v, &pos ), last( v, 0 );
+
+    EXPECT( alg::mean( first, last ).value() == static_cast<double>( expected_sum( n ) ) / static_cast<double>( expected_count( n ) ) );
+    EXPECT( pos == n );
+}
+
+CASE( "optional_algorithm: Yields an empty minimum, maximum and mean for a range without engaged elements" )
+{
+    std::vector< optional<double> > v( 3 );
+
+    EXPECT( alg::count( v.begin(), v.end() ) == 0u );
+    EXPECT( alg::sum  ( v.begin(), v.end() ) == 0.0 );
+    EXPECT_NOT( alg::min ( v.begin(), v.end() ).has_value() );
+    EXPECT_NOT( alg::max ( v.begin(), v.end() ).has_value() );
+    EXPECT_NOT( alg::mean( v.begin(), v.end() ).has_value() );
+}
+
+CASE( "optional_algorithm: Allows to reduce an optional_vector" )
+{
+    std::size_t const n = 100;
+    std::vector< optional<int> > r = make_range( n );
+    optional_vector<int> v;
+
+    for ( std::size_t i = 0; i < n; ++i )
+        v.push_back( r[i] );
+
+    EXPECT( alg::count( v ) == expected_count( n ) );
+    EXPECT( alg::sum  ( v ) == expected_sum( n ) );
+    EXPECT( alg::min  ( v ).value() == -49 );
+    EXPECT( alg::max  ( v ).value() ==  48 );
+    EXPECT( alg::mean ( v ) == alg::mean( r.begin(), r.end() ) );
+}
+
+CASE( "optional_algorithm: Allows to compact the engaged values of a column" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+        pattern<int>    pi( n );
+        pattern<double> pd( n );
+
+        // guard elements after the dense sequence must stay untouched:
+
+        std::vector<int>    oi( pi.dense.size() + 16, -1 );
+        std::vector<double> od( pd.dense.size() + 16, -1 );
+
+        int    * ei = alg::compact( ptr( pi.values ), ptr( pi.bitmap ), n, &oi[0] );
+        double * ed = alg::compact( ptr( pd.values ), ptr( pd.bitmap ), n, &od[0] );
+
+        EXPECT( ei == &oi[0] + pi.dense.size() );
+        EXPECT( ed == &od[0] + pd.dense.size() );
+        EXPECT( std::equal( pi.dense.begin(), pi.dense.end(), oi.begin() ) );
+        EXPECT( std::equal( pd.dense.begin(), pd.dense.end(), od.begin() ) );
+        EXPECT( std::count( oi.begin() + static_cast<std::ptrdiff_t>( pi.dense.size() ), oi.end(), -1 ) == 16 );
+        EXPECT( std::count( od.begin() + static_cast<std::ptrdiff_t>( pd.dense.size() ), od.end(), -1 ) == 16 );
+    }
+}
+
+CASE( "optional_algorithm: Allows to obtain the indices of the engaged elements of a column" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+        pattern<int> p( n );
+        std::vector<std::size_t> indices;
+
+        alg::compact_indices( ptr( p.bitmap ), n, std::back_inserter( indices ) );
+
+        EXPECT( (indices == p.indices) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to expand dense values into a column, value-initializing disengaged elements" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+        pattern<int>    pi( n );
+        pattern<double> pd( n );
+
+        std::vector<int>    vi( n + 1, -1 );
+        std::vector<double> vd( n + 1, -1 );
+
+        EXPECT( alg::expand( ptr( pi.dense ), ptr( pi.bitmap ), n, &vi[0] ) == &vi[0] + n );
+        EXPECT( alg::expand( ptr( pd.dense ), ptr( pd.bitmap ), n, &vd[0] ) == &vd[0] + n );
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            EXPECT( vi[i] == ( engaged( i ) ? pi.values[i] : 0 ) );
+            EXPECT( vd[i] == ( engaged( i ) ? pd.values[i] : 0 ) );
+        }
+        EXPECT( vi[n] == -1 );
+        EXPECT( vd[n] == -1 );
+    }
+}
+
+CASE( "optional_algorithm: Allows to compact a range of optional<T> and to obtain the indices of its engaged elements" )
+{
+    std::size_t const n = 200;
+    pattern<int> p( n );
+    std::vector< optional<int> > v;
+
+    for ( std::size_t i = 0; i < n; ++i )
+        v.push_back( engaged( i ) ? optional<int>( p.values[i] ) : optional<int>() );
+
+    std::vector<int> dense;
+    std::vector<std::size_t> indices;
+
+    alg::compact( v.begin(), v.end(), std::back_inserter( dense ) );
+    alg::compact_indices( v.begin(), v.end(), std::back_inserter( indices ) );
+
+    EXPECT( (dense == p.dense) );
+    EXPECT( (indices == p.indices) );
+}
+
+CASE( "optional_algorithm: Allows to expand dense values into a range of optional<T>" )
+{
+    std::size_t const n = 20;
+    pattern<int> p( n );
+    std::vector< optional<int> > v( n );
+
+    alg::expand( p.dense.begin(), ptr( p.bitmap ), n, v.begin() );
+
+    for ( std::size_t i = 0; i < n; ++i )
+    {
+        EXPECT( (v[i] == ( engaged( i ) ? optional<int>( p.values[i] ) : optional<int>() )) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to compact an optional_vector" )
+{
+    std::size_t const n = 100;
+    pattern<double> p( n );
+    optional_vector<double> v;
+
+    for ( std::size_t i = 0; i < n; ++i )
+        v.push_back( engaged( i ) ? optional<double>( p.values[i] ) : optional<double>() );
+
+    std::vector<double> dense( alg::count( v ) );
+    std::vector<std::size_t> indices;
+
+    alg::compact( v, &dense[0] );
+    alg::compact_indices( v, std::back_inserter( indices ) );
+
+    EXPECT( (dense == p.dense) );
+    EXPECT( (indices == p.indices) );
+}
+
+CASE( "optional_algorithm: Allows element-wise arithmetic of columns, disengaged where either operand is disengaged" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+
+        EXPECT( check_binary<int>( alg::add<int>, ref_add<int>, false, n ) );
+        EXPECT( check_binary<int>( alg::sub<int>, ref_sub<int>, false, n ) );
+        EXPECT( check_binary<int>( alg::mul<int>, ref_mul<int>, false, n ) );
+        EXPECT( check_binary<int>( alg::min<int>, ref_min<int>, false, n ) );
+        EXPECT( check_binary<int>( alg::max<int>, ref_max<int>, false, n ) );
+
+        EXPECT( check_binary<double>( alg::add<double>, ref_add<double>, false, n ) );
+        EXPECT( check_binary<double>( alg::sub<double>, ref_sub<double>, false, n ) );
+        EXPECT( check_binary<double>( alg::mul<double>, ref_mul<double>, false, n ) );
+        EXPECT( check_binary<double>( alg::min<double>, ref_min<double>, false, n ) );
+        EXPECT( check_binary<double>( alg::max<double>, ref_max<double>, false, n ) );
+
+        EXPECT( check_binary<short>( alg::add<short>, ref_add<short>, false, n ) );
+    }
+}
+
+CASE( "optional_algorithm: Allows element-wise division of columns, disengaged for an integer division by zero" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+
+        EXPECT( check_binary<int>   ( alg::div<int>   , ref_div<int>   , true , n ) );
+        EXPECT( check_binary<long>  ( alg::div<long>  , ref_div<long>  , true , n ) );
+        EXPECT( check_binary<double>( alg::div<double>, ref_div<double>, false, n ) );
+    }
+}
+
+CASE( "optional_algorithm: Allows element-wise division of columns, disengaged for an overflowing signed division" )
+{
+    int const int_min = (std::numeric_limits<int>::min)();
+    int const a[] = { int_min, int_min, 7, int_min };
+    int const b[] = {      -1,       2, -1,       1 };
+    unsigned char const bitmap[] = { 0x0f };
+    int out[4];
+    unsigned char out_bitmap[1];
+
+    alg::div( a, bitmap, b, bitmap, 4, out, out_bitmap );
+
+    EXPECT( out_bitmap[0] == 0x0e );
+    EXPECT( out[0] == 0 );
+    EXPECT( out[1] == int_min / 2 );
+    EXPECT( out[2] == -7 );
+    EXPECT( out[3] == int_min );
+
+    optional<int> const c[] = { int_min, int_min };
+    optional<int> const d[] = { -1, 1 };
+    optional<int> quotient[2];
+
+    alg::div( c, c + 2, d, quotient );
+
+    EXPECT( (quotient[0] == nullopt) );
+    EXPECT( quotient[1] == int_min );
+
+    unsigned int const u[] = { 0u, 7u };
+    unsigned int const v[] = { static_cast<unsigned int>( -1 ), 7u };
+    unsigned int uout[2];
+
+    alg::div( u, bitmap, v, bitmap, 2, uout, out_bitmap );
+
+    EXPECT( out_bitmap[0] == 0x03 );
+}
+
+CASE( "optional_algorithm: Allows element-wise comparison of columns, disengaged where either operand is disengaged" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+
+        EXPECT( check_compare<int>   ( alg::less<int>       , ref_less<int>    , n ) );
+        EXPECT( check_compare<int>   ( alg::equal_to<int>   , ref_equal<int>   , n ) );
+        EXPECT( check_compare<double>( alg::less<double>    , ref_less<double> , n ) );
+        EXPECT( check_compare<double>( alg::equal_to<double>, ref_equal<double>, n ) );
+        EXPECT( check_compare<long>  ( alg::less<long>      , ref_less<long>   , n ) );
+    }
+}
+
+CASE( "optional_algorithm: Allows all six element-wise comparisons of columns" )
+{
+    int const a[] = { 1, 2, 3, 1, 2, 3, 1, 2, 3 };
+    int const b[] = { 2, 2, 2, 2, 2, 2, 2, 2, 2 };
+    unsigned char const a_bitmap[] = { 0xff, 0x01 };
+    unsigned char const b_bitmap[] = { 0xff, 0x00 };
+    unsigned char out[2], out_bitmap[2];
+
+    alg::equal_to     ( a, a_bitmap, b, b_bitmap, 9, out, out_bitmap ); EXPECT( out[0] == 0x92 );
+    alg::not_equal_to ( a, a_bitmap, b, b_bitmap, 9, out, out_bitmap ); EXPECT( out[0] == 0x6d );
+    alg::less         ( a, a_bitmap, b, b_bitmap, 9, out, out_bitmap ); EXPECT( out[0] == 0x49 );
+    alg::less_equal   ( a, a_bitmap, b, b_bitmap, 9, out, out_bitmap ); EXPECT( out[0] == 0xdb );
+    alg::greater      ( a, a_bitmap, b, b_bitmap, 9, out, out_bitmap ); EXPECT( out[0] == 0x24 );
+    alg::greater_equal( a, a_bitmap, b, b_bitmap, 9, out, out_bitmap ); EXPECT( out[0] == 0xb6 );
+
+    EXPECT( out_bitmap[0] == 0xff );
+    EXPECT( out_bitmap[1] == 0x00 );
+    EXPECT( out[1] == 0x00 );
+}
+
+CASE( "optional_algorithm: Allows element-wise operations on ranges of optional<T>" )
+{
+    optional<int> const a[] = { 6, 6, optional<int>(), 6 };
+    optional<int> const b[] = { 3, 0, 3, optional<int>() };
+    optional<int> sum[4], quotient[4];
+    optional<bool> less[4];
+
+    alg::add ( a, a + 4, b, sum );
+    alg::div ( a, a + 4, b, quotient );
+    alg::less( a, a + 4, b, less );
+
+    EXPECT( sum[0] == 9 );
+    EXPECT( sum[1] == 6 );
+    EXPECT( (sum[2] == nullopt) );
+    EXPECT( (sum[3] == nullopt) );
+    EXPECT( quotient[0] == 2 );
+    EXPECT( (quotient[1] == nullopt) );
+    EXPECT( less[0] == false );
+    EXPECT( (less[2] == nullopt) );
+}
+
+CASE( "optional_algorithm: Allows element-wise arithmetic of optional_vectors" )
+{
+    optional_vector<int> a, b;
+
+    for ( int i = 0; i < 20; ++i )
+    {
+        a.push_back( i % 2 ? optional<int>( i ) : optional<int>() );
+        b.push_back( i % 3 ? optional<int>( 10 ) : optional<int>() );
+    }
+
+    optional_vector<int> r = alg::mul( a, b );
+
+    EXPECT( r.size() == 20u );
+    EXPECT( r[1] == 10 );
+    EXPECT( (r[2] == nullopt) );
+    EXPECT( (r[3] == nullopt) );
+    EXPECT( r[19] == 190 );
+    EXPECT( r.values()[3] == 0 );
+    EXPECT( alg::count( r ) == 7u );
+}
+
+CASE( "optional_algorithm: Allows to fill the disengaged elements of a column with a value" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+        pattern<int>    pi( n );
+        pattern<double> pd( n );
+
+        std::vector<int>    oi( n + 1, -1 );
+        std::vector<double> od( n + 1, -1 );
+
+        EXPECT( alg::fill_missing( ptr( pi.values ), ptr( pi.bitmap ), n, 7, &oi[0] ) == &oi[0] + n );
+        EXPECT( alg::fill_missing( ptr( pd.values ), ptr( pd.bitmap ), n, 7, &od[0] ) == &od[0] + n );
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            EXPECT( oi[i] == ( engaged( i ) ? pi.values[i] : 7 ) );
+            EXPECT( od[i] == ( engaged( i ) ? pd.values[i] : 7 ) );
+        }
+        EXPECT( oi[n] == -1 );
+        EXPECT( od[n] == -1 );
+    }
+}
+
+CASE( "optional_algorithm: Allows to fill the disengaged elements of a column from an array of defaults" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        std::size_t const n = pattern_sizes[k];
+        pattern<int>    pi( n );
+        pattern<double> pd( n );
+
+        std::vector<int>    di( n ), oi( n + 1 );
+        std::vector<double> dd( n ), od( n + 1 );
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            di[i] = -static_cast<int>( i );
+            dd[i] = -static_cast<double>( i );
+        }
+
+        alg::fill_missing( ptr( pi.values ), ptr( pi.bitmap ), n, ptr( di ), &oi[0] );
+        alg::fill_missing( ptr( pd.values ), ptr( pd.bitmap ), n, ptr( dd ), &od[0] );
+
+        for ( std::size_t i = 0; i < n; ++i )
+        {
+            EXPECT( oi[i] == ( engaged( i ) ? pi.values[i] : di[i] ) );
+            EXPECT( od[i] == ( engaged( i ) ? pd.values[i] : dd[i] ) );
+        }
+    }
+}
+
+CASE( "optional_algorithm: Allows to fill the disengaged elements of a column in place" )
+{
+    pattern<double> p( 100 );
+
+    alg::fill_missing( ptr( p.values ), ptr( p.bitmap ), 100, -1, ptr( p.values ) );
+
+    EXPECT( p.values[0] == 1000 );
+    EXPECT( p.values[2] == -1 );
+    EXPECT( std::count( p.values.begin(), p.values.end(), -1.0 ) == 100 - static_cast<std::ptrdiff_t>( p.dense.size() ) );
+}
+
+CASE( "optional_algorithm: Allows to fill the disengaged elements of a range of optional<T>" )
+{
+    optional<int> const a[] = { 1, optional<int>(), 3, optional<int>() };
+    int const defaults[] = { 10, 20, 30, 40 };
+    std::vector<int> with_value, with_defaults;
+
+    alg::fill_missing( a, a + 4, 0, std::back_inserter( with_value ) );
+    alg::fill_missing( a, a + 4, defaults, std::back_inserter( with_defaults ) );
+
+    EXPECT( with_value[0] ==  1 );
+    EXPECT( with_value[1] ==  0 );
+    EXPECT( with_value[3] ==  0 );
+    EXPECT( with_defaults[1] == 20 );
+    EXPECT( with_defaults[2] ==  3 );
+    EXPECT( with_defaults[3] == 40 );
+}
+
+CASE( "optional_algorithm: Allows to fill the disengaged elements of an optional_vector" )
+{
+    optional_vector<double> v;
+    double const defaults[] = { 10, 20, 30 };
+    double out[3];
+
+    v.push_back( 1.5 );
+    v.push_back( nullopt );
+    v.push_back( nullopt );
+
+    alg::fill_missing( v, 0, out );
+    EXPECT( out[0] == 1.5 );
+    EXPECT( out[1] == 0.0 );
+
+    alg::fill_missing( v, defaults, out );
+    EXPECT( out[0] == 1.5 );
+    EXPECT( out[2] == 30.0 );
+}
+
+CASE( "optional_algorithm: Allows to fill a column forward with the last engaged value, up to a limit" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        for ( std::size_t l = 0; l < sizeof fill_limits / sizeof fill_limits[0]; ++l )
+        {
+            EXPECT( check_fill( true, pattern_sizes[k], engaged, fill_limits[l] ) );
+            EXPECT( check_fill( true, pattern_sizes[k], sparse , fill_limits[l] ) );
+        }
+    }
+}
+
+CASE( "optional_algorithm: Allows to fill a column backward with the next engaged value, up to a limit" )
+{
+    for ( std::size_t k = 0; k < sizeof pattern_sizes / sizeof pattern_sizes[0]; ++k )
+    {
+        for ( std::size_t l = 0; l < sizeof fill_limits / sizeof fill_limits[0]; ++l )
+        {
+            EXPECT( check_fill( false, pattern_sizes[k], engaged, fill_limits[l] ) );
+            EXPECT( check_fill( false, pattern_sizes[k], sparse , fill_limits[l] ) );
+        }
+    }
+}
+
+CASE( "optional_algorithm: Allows to fill a column forward and backward in place" )
+{
+    int values[] = { 0, 1, 0, 0, 4, 0 };
+    unsigned char bitmap[] = { 0x12 };
+
+    alg::ffill( values, bitmap, 6, values, bitmap );
+
+    EXPECT( bitmap[0] == 0x3e );
+    EXPECT( values[0] == 0 );
+    EXPECT( values[3] == 1 );
+    EXPECT( values[5] == 4 );
+
+    bitmap[0] = 0x12;
+    alg::bfill( values, bitmap, 6, values, bitmap, 1 );
+
+    EXPECT( bitmap[0] == 0x1b );
+    EXPECT( values[0] == 1 );
+    EXPECT( values[2] == 0 );
+    EXPECT( values[3] == 4 );
+    EXPECT( values[5] == 0 );
+}
+
+CASE( "optional_algorithm: Allows to fill a range of optional<T> forward and backward, up to a limit" )
+{
+    optional<double> const ticks[] = { optional<double>(), 1.5, optional<double>(), optional<double>(), 2.5, optional<double>() };
+    std::vector< optional<double> > f, b( 6 ), l;
+
+    alg::ffill( ticks, ticks + 6, std::back_inserter( f ) );
+    EXPECT( (b.end() == alg::bfill( ticks, ticks + 6, b.begin() )) );
+    alg::ffill( ticks, ticks + 6, std::back_inserter( l ), 1 );
+
+    EXPECT( (f[0] == nullopt) );
+    EXPECT( f[3] == 1.5 );
+    EXPECT( f[5] == 2.5 );
+    EXPECT( b[0] == 1.5 );
+    EXPECT( b[2] == 2.5 );
+    EXPECT( (b[5] == nullopt) );
+    EXPECT( l[2] == 1.5 );
+    EXPECT( (l[3] == nullopt) );
+}
+
+CASE( "optional_algorithm: Allows to fill an optional_vector forward and backward, up to a limit" )
+{
+    optional_vector<int> v;
+
+    v.push_back( 1 );
+    v.push_back( nullopt );
+    v.push_back( nullopt );
+    v.push_back( 4 );
+
+    optional_vector<int> const f = alg::ffill( v );
+    optional_vector<int> const b = alg::bfill( v, 1 );
+
+    EXPECT( f[2] == 1 );
+    EXPECT( f.bitmap()[0] == 0x0f );
+    EXPECT( (b[1] == nullopt) );
+    EXPECT( b.values()[1] == 0 );
+    EXPECT( b[2] == 4 );
+}
+
+CASE( "optional_algorithm: Allows to sort a range of optional<T> with the disengaged elements first or last" )
+{
+    for ( std::size_t k = 0; k < sizeof sort_sizes / sizeof sort_sizes[0]; ++k )
+    {
+        std::size_t const n = sort_sizes[k];
+
+        EXPECT( (check_sort<int>   ( n, alg::nulls_first, std::less<int>()    )) );
+        EXPECT( (check_sort<int>   ( n, alg::nulls_last , std::less<int>()    )) );
+        EXPECT( (check_sort<double>( n, alg::nulls_first, std::less<double>() )) );
+        EXPECT( (check_sort<double>( n, alg::nulls_last , std::less<double>() )) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to sort a range of optional<T> in descending order" )
+{
+    for ( std::size_t k = 0; k < sizeof sort_sizes / sizeof sort_sizes[0]; ++k )
+    {
+        std::size_t const n = sort_sizes[k];
+
+        EXPECT( (check_sort<long long>     ( n, alg::nulls_last , std::greater<long long>()      )) );
+        EXPECT( (check_sort<float>         ( n, alg::nulls_first, std::greater<float>()          )) );
+        EXPECT( (check_sort<unsigned short>( n, alg::nulls_last , std::greater<unsigned short>() )) );
+    }
+}
+
+CASE( "optional_algorithm: Allows to sort a range of optional<T> by a comparison" )
+{
+    std::list< optional<std::string> > v;
+
+    v.push_back( std::string( "pear" ) );
+    v.push_back( nullopt );
+    v.push_back( std::string( "fig" ) );
+    v.push_back( std::string( "banana" ) );
+
+    alg::sort_optional( v.begin(), v.end(), alg::nulls_last, longer() );
+
+    std::list< optional<std::string> >::const_iterator pos = v.begin();
+
+    EXPECT( *pos++ == std::string( "banana" ) );
+    EXPECT( *pos++ == std::string( "pear" ) );
+    EXPECT( *pos++ == std::string( "fig" ) );
+    EXPECT( (*pos == nullopt) );
+}
+
+CASE( "optional_algorithm: Sorts a range of optional<T> with the disengaged elements first by default" )
+{
+    std::vector< optional<int> > v = unsorted<int>( 1000 );
+    std::vector< optional<int> > expected( v );
+
+    std::sort( expected.begin(), expected.end() );
+    alg::sort_optional( v.begin(), v.end() );
+
+    EXPECT( (v == expected) );
+}
+
+CASE( "optional_algorithm: Sorts a range of optional<double> with NaNs and signed zeros by their bits" )
+{
+    for ( std::size_t k = 0; k < sizeof sort_sizes / sizeof sort_sizes[0]; ++k )
+    {
+        std::vector< optional<double> > v = special_doubles( sort_sizes[k] );
+        std::vector< optional<double> > expected( v );
+
+        std::sort( expected.begin(), expected.end(), by_bits() );
+        alg::sort_optional( v.begin(), v.end() );
+
+        bool same = true;
+        for ( std::size_t i = 0; i < v.size(); ++i )
+            same = same && v[i].has_value() == expected[i].has_value() && ( ! v[i] || by_bits::key( *v[i] ) == by_bits::key( *expected[i] ) );
+
+        EXPECT( same );
+    }
+}
+
+CASE( "optional_algorithm: Moves the values when sorting (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    std::vector< optional<copy_counted> > v;
+    optional_vector<copy_counted> c;
+
+    for ( int i = 0; i < 100; ++i )
+    {
+        v.push_back( i % 4 ? optional<copy_counted>( ( i * 37 ) % 100 ) : optional<copy_counted>() );
+        c.push_back( copy_counted( ( i * 37 ) % 100 ) );
+    }
+
+    copy_counted::copies = 0;
+    alg::sort_optional( v.begin(), v.end(), alg::nulls_last, std::less<copy_counted>() );
+    alg::sort_optional( c );
+
+    EXPECT( copy_counted::copies == 0 );
+    EXPECT( v[0]->value == 1 );
+    EXPECT( (v[99] == nullopt) );
+    EXPECT( c[0]->value == 0 );
+    EXPECT( c[99]->value == 99 );
+#else
+    EXPECT( !!"optional_algorithm: move is not available (no C++11)" );
+#endif
+}
+
+CASE( "optional_algorithm: Allows to sort an optional_vector with the disengaged elements first or last" )
+{
+    std::vector< optional<int> > const in = unsorted<int>( 300 );
+    std::vector< optional<int> > expected( in );
+    optional_vector<int> first, last;
+
+    for ( std::size_t i = 0; i < in.size(); ++i )
+    {
+        first.push_back( in[i] );
+        last.push_back( in[i] );
+    }
+
+    std::sort( expected.begin(), expected.end() );
+    alg::sort_optional( first );
+    alg::sort_optional( last, alg::nulls_last, std::greater<int>() );
+
+    std::size_t const nulls = static_cast<std::size_t>( std::count( in.begin(), in.end(), optional<int>() ) );
+
+    EXPECT( std::equal( expected.begin(), expected.end(), first.begin() ) );
+    EXPECT( std::equal( expected.rbegin(), expected.rend() - static_cast<std::ptrdiff_t>( nulls ), last.begin() ) );
+    EXPECT( (last[ 300 - nulls ] == nullopt) );
+    EXPECT( last.values()[299] == 0 );
+    EXPECT( last.bitmap()[37] == 0 );
+}
+
+// end of file
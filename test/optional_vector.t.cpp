@@ -0,0 +1,174 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.t.hpp"
+#include "nonstd/optional_vector.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+using namespace nonstd;
+
+namespace {
+
+// whether the category of an iterator is exactly the input iterator category:
+
+bool is_input_iterator_tag( std::input_iterator_tag   ) { return true;  }
+bool is_input_iterator_tag( std::forward_iterator_tag ) { return false; }
+
+// sequence 1, empty, 3, empty, ..., of n elements:
+
+optional_vector<int> make_sequence( std::size_t n )
+{
+    optional_vector<int> v;
+
+    for ( std::size_t i = 0; i < n; ++i )
+        v.push_back( i % 2 ? optional<int>() : optional<int>( static_cast<int>( i + 1 ) ) );
+
+    return v;
+}
+
+} // anonymous namespace
+
+CASE( "optional_vector: Allows to default construct an empty sequence" )
+{
+    optional_vector<int> v;
+
+    EXPECT( v.empty() );
+    EXPECT( v.size() == 0u );
+    EXPECT( (v.begin() == v.end()) );
+}
+
+CASE( "optional_vector: Allows to construct a sequence of disengaged elements" )
+{
+    optional_vector<int> v( 10 );
+
+    EXPECT( v.size() == 10u );
+    EXPECT( std::count( v.begin(), v.end(), optional<int>() ) == 10 );
+}
+
+CASE( "optional_vector: Allows to push_back engaged and disengaged elements" )
+{
+    optional_vector<int> v = make_sequence( 20 );
+
+    EXPECT( v.size() == 20u );
+    EXPECT( v[0] == 1 );
+    EXPECT( (v[1] == nullopt) );
+    EXPECT( v[18] == 19 );
+    EXPECT( (v[19] == nullopt) );
+    EXPECT( v.has_value( 18 ) );
+    EXPECT_NOT( v.has_value( 19 ) );
+}
+
+CASE( "optional_vector: Stores values densely and the engaged state in a bitmap" )
+{
+    optional_vector<int> v = make_sequence( 10 );
+
+    EXPECT( v.values()[0] == 1 );
+    EXPECT( v.values()[1] == 0 );
+    EXPECT( v.values()[2] == 3 );
+    EXPECT( v.bitmap()[0] == 0x55 );
+    EXPECT( v.bitmap()[1] == 0x01 );
+}
+
+CASE( "optional_vector: Allows to iterate over the elements" )
+{
+    optional_vector<int> v = make_sequence( 9 );
+    optional_vector<int>::const_iterator pos = v.begin();
+
+    EXPECT( v.end() - v.begin() == 9 );
+    EXPECT( *pos == 1 );
+    EXPECT( (*++pos == nullopt) );
+    EXPECT( pos[1] == 3 );
+    EXPECT( *( v.end() - 1 ) == 9 );
+    EXPECT( std::count( v.begin(), v.end(), optional<int>() ) == 4 );
+}
+
+CASE( "optional_vector: Provides input iterators, which C++20 considers random access iterators" )
+{
+    typedef optional_vector<int>::const_iterator iterator;
+
+    EXPECT( is_input_iterator_tag( std::iterator_traits<iterator>::iterator_category() ) );
+#if optional_CPP20_OR_GREATER
+    EXPECT( std::random_access_iterator<iterator> );
+#endif
+}
+
+CASE( "optional_vector: Allows to set and reset elements" )
+{
+    optional_vector<int> v( 3 );
+
+    v.set( 1, 42 );
+    EXPECT( v[1] == 42 );
+
+    v.set( 1, nullopt );
+    EXPECT( (v[1] == nullopt) );
+    EXPECT( v.values()[1] == 0 );
+
+    v.set( 2, 7 );
+    v.reset( 2 );
+    EXPECT( (v[2] == nullopt) );
+}
+
+CASE( "optional_vector: Allows to pop_back, resize and clear, keeping unused bitmap bits zero" )
+{
+    optional_vector<int> v = make_sequence( 9 );
+
+    v.pop_back();
+    EXPECT( v.size() == 8u );
+    EXPECT( v.bitmap()[0] == 0x55 );
+
+    v.resize( 3 );
+    EXPECT( v.bitmap()[0] == 0x05 );
+
+    v.resize( 5 );
+    EXPECT( (v[4] == nullopt) );
+
+    v.clear();
+    EXPECT( v.empty() );
+}
+
+CASE( "optional_vector: Allows to reserve capacity" )
+{
+    optional_vector<int> v;
+
+    v.reserve( 100 );
+
+    EXPECT( v.capacity() >= 100u );
+}
+
+CASE( "optional_vector: Allows to swap sequences" )
+{
+    optional_vector<int> a = make_sequence( 3 );
+    optional_vector<int> b;
+
+    swap( a, b );
+
+    EXPECT( a.empty() );
+    EXPECT( b.size() == 3u );
+    EXPECT( b[2] == 3 );
+}
+
+CASE( "optional_vector: Allows to refer to an element via optional<T&>" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"optional_vector: ref() is not available (std::optional)" );
+#else
+    optional_vector<std::string> v;
+
+    v.push_back( std::string( "abc" ) );
+    v.push_back( nullopt );
+
+    v.ref( 0 )->append( "def" );
+
+    EXPECT( v[0] == std::string( "abcdef" ) );
+    EXPECT_NOT( v.ref( 1 ).has_value() );
+#endif
+}
+
+// end of file
@@ -0,0 +1,249 @@
+// Copyright 2017-2019 by Martin Moene
+//
+// https://github.com/martinmoene/optional-bare
+//
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+
+#include "optional-main.t.hpp"
+#include "nonstd/slot_map.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace nonstd;
+
+namespace {
+
+typedef slot_map<int>::handle handle;
+
+// sum of the objects, visiting them via the iterators:
+
+int sum( slot_map<int> const & m )
+{
+    int result = 0;
+
+    for ( slot_map<int>::const_iterator pos = m.begin(); pos != m.end(); ++pos )
+        result += *pos;
+
+    return result;
+}
+
+// object whose copy throws while 'fail' is set:
+
+struct throwing
+{
+    static bool fail;
+    int value;
+
+    throwing( int v = 0 ) : value( v ) {}
+    throwing( throwing const & other ) : value( other.value ) { if ( fail ) throw 42; }
+    throwing & operator=( throwing const & other ) { value = other.value; return *this; }
+};
+
+bool throwing::fail = false;
+
+} // anonymous namespace
+
+CASE( "slot_map: Allows to default construct an empty map" )
+{
+    slot_map<int> m;
+
+    EXPECT( m.empty() );
+    EXPECT( m.size() == 0u );
+    EXPECT( (m.begin() == m.end()) );
+    EXPECT_NOT( m.contains( handle() ) );
+    EXPECT_NOT( m.get( handle() ).has_value() );
+}
+
+CASE( "slot_map: Allows to insert objects and to look them up by handle" )
+{
+    slot_map<int> m;
+    std::vector<handle> h;
+
+    for ( int i = 0; i < 100; ++i )
+        h.push_back( m.insert( 10 * i ) );
+
+    EXPECT( m.size() == 100u );
+
+    for ( std::size_t i = 0; i < h.size(); ++i )
+    {
+        int const value = 10 * static_cast<int>( i );
+
+        EXPECT( m.contains( h[i] ) );
+        EXPECT( m.get( h[i] ) == value );
+        EXPECT( m[ h[i] ] == value );
+    }
+}
+
+CASE( "slot_map: Allows to erase objects, invalidating their handles only" )
+{
+    slot_map<int> m;
+    handle a = m.insert( 1 );
+    handle b = m.insert( 2 );
+    handle c = m.insert( 3 );
+
+    EXPECT(     m.erase( a ) );
+    EXPECT_NOT( m.erase( a ) );
+
+    EXPECT( m.size() == 2u );
+    EXPECT_NOT( m.contains( a ) );
+    EXPECT( (m.get( a ) == nullopt) );
+    EXPECT( m.get( b ) == 2 );
+    EXPECT( m.get( c ) == 3 );
+    EXPECT( sum( m ) == 5 );
+}
+
+CASE( "slot_map: Reuses the slot of an erased object with a new generation" )
+{
+    slot_map<int> m;
+    handle a = m.insert( 1 );
+
+    m.erase( a );
+    handle b = m.insert( 2 );
+
+    EXPECT( b.index == a.index );
+    EXPECT( b.generation != a.generation );
+    EXPECT( (b != a) );
+    EXPECT_NOT( m.contains( a ) );
+    EXPECT( m.get( b ) == 2 );
+}
+
+CASE( "slot_map: Keeps handles valid and objects dense under churn" )
+{
+    slot_map<int> m;
+    std::vector<handle> h;
+    std::set<int> live;
+
+    for ( int i = 0; i < 64; ++i )
+    {
+        h.push_back( m.insert( i ) );
+        live.insert( i );
+    }
+
+    for ( std::size_t round = 0; round < 1000; ++round )
+    {
+        std::size_t const k = ( round * 37 ) % 64;
+
+        if ( m.take( h[k] ) == nullopt )
+        {
+            h[k] = m.insert( static_cast<int>( k ) );
+            live.insert( static_cast<int>( k ) );
+        }
+        else
+        {
+            live.erase( static_cast<int>( k ) );
+        }
+    }
+
+    EXPECT( m.size() == live.size() );
+
+    for ( int k = 0; k < 64; ++k )
+        EXPECT( m.get( h[ static_cast<std::size_t>( k ) ] ) == ( live.count( k ) ? optional<int>( k ) : optional<int>() ) );
+
+    for ( std::size_t i = 0; i < m.size(); ++i )
+        EXPECT( m[ m.handle_at( i ) ] == *( m.begin() + static_cast<std::ptrdiff_t>( i ) ) );
+}
+
+CASE( "slot_map: Does not match a default handle after a throwing first insertion" )
+{
+    slot_map<throwing> m;
+    throwing const x( 1 );
+
+    throwing::fail = true;
+    try { m.insert( x ); } catch ( int ) {}
+    throwing::fail = false;
+
+    slot_map<throwing>::handle const h;
+
+    EXPECT( m.empty() );
+    EXPECT_NOT( m.contains( h ) );
+    EXPECT_NOT( m.get( h ).has_value() );
+    EXPECT_NOT( m.take( h ).has_value() );
+    EXPECT_NOT( m.erase( h ) );
+
+    slot_map<throwing>::handle const k = m.insert( x );
+
+    EXPECT( m.contains( k ) );
+    EXPECT( m.get( k )->value == 1 );
+    EXPECT( m.size() == 1u );
+}
+
+CASE( "slot_map: Allows to take an object out by handle" )
+{
+    slot_map<std::string> m;
+    slot_map<std::string>::handle h = m.insert( "abc" );
+
+    EXPECT( m.take( h ) == std::string( "abc" ) );
+    EXPECT( (m.take( h ) == nullopt) );
+    EXPECT( m.empty() );
+}
+
+CASE( "slot_map: Allows to move objects in and out and to construct them in place (C++11)" )
+{
+#if optional_CPP11_OR_GREATER
+    slot_map<std::string> m;
+    std::string text( "a string that does not fit a small string buffer" );
+    char const * const data = text.data();
+
+    slot_map<std::string>::handle h1 = m.insert( std::move( text ) );
+    slot_map<std::string>::handle h2 = m.emplace( 3u, 'x' );
+    slot_map<std::string>::handle h3 = m.emplace( "abc" );
+
+    EXPECT( m[ h1 ].data() == data );
+    EXPECT( m[ h2 ] == "xxx" );
+
+    m.erase( h2 );
+
+    EXPECT( m[ h3 ] == "abc" );
+
+    std::string const taken = *m.take( h1 );
+
+    EXPECT( taken.data() == data );
+    EXPECT( m.size() == 1u );
+    EXPECT( m[ h3 ] == "abc" );
+#else
+    EXPECT( !!"slot_map: move and in-place construction are not available (no C++11)" );
+#endif
+}
+
+CASE( "slot_map: Allows to copy, swap and clear maps" )
+{
+    slot_map<int> a;
+    handle h = a.insert( 1 );
+    a.insert( 2 );
+
+    slot_map<int> b( a );
+    slot_map<int> c;
+
+    swap( b, c );
+
+    EXPECT( b.empty() );
+    EXPECT( c.get( h ) == 1 );
+    EXPECT( sum( c ) == 3 );
+
+    a.clear();
+
+    EXPECT( a.empty() );
+    EXPECT_NOT( a.contains( h ) );
+    EXPECT( a.insert( 5 ).index < 2u );
+}
+
+CASE( "slot_map: Allows to refer to an object via optional<T&>" )
+{
+#if optional_USES_STD_OPTIONAL
+    EXPECT( !!"slot_map: find() is not available (std::optional)" );
+#else
+    slot_map<std::string> m;
+    slot_map<std::string>::handle h = m.insert( "abc" );
+
+    m.find( h )->append( "def" );
+
+    EXPECT( m.get( h ) == std::string( "abcdef" ) );
+    m.erase( h );
+    EXPECT_NOT( m.find( h ).has_value() );
+#endif
+}
+
+// end of file